@@ -0,0 +1,203 @@
+// Anytime Repairing A* (ARA*): a weighted A* that finds a first solution
+// quickly and then lowers the weight, reusing its earlier work, until the
+// deadline passes (or the search is cancelled) or the solution is proven
+// optimal.
+#pragma once
+
+#include <chrono>
+#include <vector>
+
+#include "functions.h"
+#include "open_list.h"
+#include "puzzle_search.h"
+#include "search_stats.h"
+#include "search_stop.h"
+
+using namespace std;
+
+// -------------- Weights --------------
+// Weights are kept in tenths so that the open list keys, 10 g + w h, stay
+// integers and fit the bucket queue
+const int araInitialWeight = 30;                                          // First search uses f = g + 3 h
+const int araWeightStep = 5;                                              // Lowered by 0.5 after every solution
+const int araNoCost = 1 << 30;                                            // g of a board not reached yet
+
+// Node of the ARA* search, one per board reached
+struct AnytimeNode {
+  uint64_t key;
+  int blank;
+  int parent;                                                             // Index of the parent node, -1 for the root
+  int g, h;
+  int closedIn;                                                           // Last iteration that expanded the node, -1 if none
+  bool open, inconsistent;                                                // In OPEN, or improved after being expanded
+};
+
+// ARA* with the heuristic functor already picked, see below
+template <int W, int H, typename Heuristic>
+bool anytimeAStar(const Board<W, H> &board, const Heuristic &heuristic, const SearchStop &stop, vector<int> &blankPath,
+                  double &bound) {
+  const PuzzleTables<W, H> &tables = puzzleTables<W, H>;
+  blankPath.clear();
+  if (!isBoardSolvable(board)) return false;
+
+  startStats();
+  vector<AnytimeNode> nodes;
+  PackedHashMap<int> nodeOf;                                              // Node of every board reached
+  BucketQueue frontier;                                                   // Keys 10 g + w h, stale entries skipped
+  vector<int> openNodes, inconsistentNodes;                               // May hold nodes that have since left the set
+  const uint64_t goalKey = packBoardKey(goalBoard<W, H>());
+  int goalNode = -1;
+  bool found = false;
+
+  nodes.push_back({packBoardKey(board), board.blank, -1, 0, heuristic(board), -1, true, false});
+  chargeTime(searchStats.heuristicSeconds);
+  nodeOf[PackedState(nodes[0].key)] = 0;
+  if (nodes[0].key == goalKey) goalNode = 0;
+  openNodes.push_back(0);
+
+  bool stopped = false;
+  int sinceCheck = 0;
+  for (int iteration = 0, weight = araInitialWeight; !stopped; ++iteration) {
+    frontier.clear();                                                     // Rebuild OPEN with the new weight
+    vector<int> merged;
+    for (int index : openNodes) {
+      if (nodes[index].open) merged.push_back(index);
+    }
+    for (int index : inconsistentNodes) {
+      if (!nodes[index].inconsistent) continue;
+      nodes[index].inconsistent = false;
+      nodes[index].open = true;
+      merged.push_back(index);
+    }
+    inconsistentNodes.clear();
+    openNodes.swap(merged);
+    for (int index : openNodes) frontier.push({10 * nodes[index].g + weight * nodes[index].h, nodes[index].g, index});
+
+    while (!frontier.empty()) {                                           // Improve the path
+      OpenEntry entry = frontier.top();
+      if (goalNode >= 0 && 10 * nodes[goalNode].g <= entry.f) break;      // No open board can lead to a cheaper goal
+      frontier.pop();
+      AnytimeNode node = nodes[entry.node];
+      if (!node.open || entry.g != node.g) {                              // Expanded already, or reached more cheaply since
+        countStat(searchStats.duplicateHits);
+        continue;
+      }
+      if (++sinceCheck == stopCheckInterval) {
+        sinceCheck = 0;
+        if (stop.requested()) {
+          stopped = true;
+          break;
+        }
+      }
+      nodes[entry.node].open = false;
+      nodes[entry.node].closedIn = iteration;
+
+      countStat(searchStats.nodesExpanded);
+      for (int d = 0; d < 4; ++d) {
+        chargeTime(searchStats.bookkeepingSeconds);
+        int newBlank = tables.neighbors[node.blank][d];
+        if (newBlank < 0) continue;
+        uint64_t tile = (node.key >> (4 * newBlank)) & packedCellMask;
+        uint64_t childKey = (node.key & ~(packedCellMask << (4 * newBlank))) | (tile << (4 * node.blank));
+        countStat(searchStats.nodesGenerated);
+        chargeTime(searchStats.expansionSeconds);
+
+        bool inserted;
+        int child = nodeOf.insert(PackedState(childKey), int(nodes.size()), inserted);
+        if (inserted) {
+          int childH = heuristic.afterMove(node.h, tile, newBlank, node.blank, childKey);
+          chargeTime(searchStats.heuristicSeconds);
+          nodes.push_back({childKey, newBlank, -1, araNoCost, childH, -1, false, false});
+          if (childKey == goalKey) goalNode = child;
+        }
+        AnytimeNode &reached = nodes[child];
+        if (reached.g <= node.g + 1) {                                    // Not an improvement over the known path
+          countStat(searchStats.duplicateHits);
+          continue;
+        }
+        reached.g = node.g + 1;
+        reached.parent = entry.node;
+        if (reached.closedIn == iteration) {                              // Expanded in this iteration, wait for the next
+          if (!reached.inconsistent) inconsistentNodes.push_back(child);
+          reached.inconsistent = true;
+        } else {
+          if (!reached.open) openNodes.push_back(child);
+          reached.open = true;
+          frontier.push({10 * reached.g + weight * reached.h, reached.g, child});
+        }
+      }
+      peakStat(searchStats.peakFrontier, frontier.size());
+    }
+
+    if (stopped || goalNode < 0 || nodes[goalNode].g == araNoCost) break; // Nothing new to publish
+    int lowest = araNoCost;                                               // Lowest g + h in OPEN and INCONS
+    for (int index : openNodes) {
+      if (nodes[index].open) lowest = min(lowest, nodes[index].g + nodes[index].h);
+    }
+    for (int index : inconsistentNodes) lowest = min(lowest, nodes[index].g + nodes[index].h);
+    int cost = nodes[goalNode].g;
+    bound = lowest >= cost ? 1.0 : min(weight / 10.0, double(cost) / lowest);
+    blankPath.clear();
+    for (int index = goalNode; nodes[index].parent >= 0; index = nodes[index].parent) blankPath.push_back(nodes[index].blank);
+    reverse(blankPath.begin(), blankPath.end());
+    found = true;
+    if (bound <= 1.0) break;                                              // Proven optimal
+    weight = max(10, weight - araWeightStep);
+  }
+
+  chargeTime(searchStats.bookkeepingSeconds);
+  peakStat(searchStats.peakVisited, nodeOf.size());
+  peakStat(searchStats.bytesAllocated, nodes.capacity() * sizeof(AnytimeNode) + nodeOf.bytes() + frontier.bytes() +
+                                           (openNodes.capacity() + inconsistentNodes.capacity()) * sizeof(int));
+  return found;
+}
+
+/**
+ * @title Anytime Weighted A*
+ * @brief Runs ARA* on a W x H board until it is stopped. Each iteration is a
+ * weighted A* on f = g + w h that stops as soon as no open board has a lower
+ * key than the goal. Boards improved after their expansion in an iteration
+ * are set aside as inconsistent and rejoin the open list for the next one,
+ * with a weight 0.5 lower, so no work is repeated. After every iteration the
+ * best path is kept along with its proven bound: the path costs at most
+ * bound times the optimum, with bound the lower of the weight and the path
+ * cost over the lowest g + h still open. A bound of 1 means optimal. The
+ * bound only holds for the admissible heuristics 1, 2 and 4.
+ *
+ * @param board The initial board.
+ * @param heuristicType The heuristic to use, as numbered in the menu, picked
+ * once before the search starts.
+ * @param stop When to stop improving and return the best path found: the
+ * deadline, or cancellation from another thread.
+ * @param blankPath Filled with the blank index after each move.
+ * @param bound Set to the proven suboptimality bound of blankPath.
+ * @return true if a path was found before the stop.
+ */
+template <int W, int H>
+bool anytimeAStar(const Board<W, H> &board, int heuristicType, const SearchStop &stop, vector<int> &blankPath,
+                  double &bound) {
+  return withBoardHeuristic<W, H>(heuristicType, [&](const auto &heuristic) {
+    return anytimeAStar(board, heuristic, stop, blankPath, bound);
+  });
+}
+
+// Solves an 8-puzzle with ARA* for at most the given time, path from the
+// initial state to the goal and its proven suboptimality bound
+vector<State> anytimeBestFirstSearch(const State &initialState, int heuristicType, chrono::milliseconds timeLimit,
+                                     double &bound) {
+  vector<int> blankPath;
+  if (!anytimeAStar(makeBoard<3, 3>(initialState.board), heuristicType, stopAfter(timeLimit), blankPath, bound)) {
+    return vector<State>();
+  }
+  return replayBlankPath(initialState, blankPath);
+}
+
+// Solves an 8-puzzle with ARA* for at most the given time, moves from the
+// initial state to the goal and their proven suboptimality bound
+bool anytimeBestFirstSearch(const State &initialState, int heuristicType, chrono::milliseconds timeLimit, double &bound,
+                            MoveSequence &moves) {
+  vector<int> blankPath;
+  bool found = anytimeAStar(makeBoard<3, 3>(initialState.board), heuristicType, stopAfter(timeLimit), blankPath, bound);
+  moves = MoveSequence::fromBlankPath<3, 3>(findBlankIndex(initialState), blankPath);
+  return found;
+}
@@ -0,0 +1,600 @@
+// Non-interactive batch mode: solves many puzzles from a file or stdin across
+// a thread pool and streams the results in input order.
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "anytime_search.h"
+#include "distance_db.h"
+#include "functions.h"
+#include "parallel_bfs.h"
+#include "parallel_search.h"
+#include "puzzle_search.h"
+#include "result_writer.h"
+#include "solution_cache.h"
+#include "symmetry.h"
+
+using namespace std;
+
+// -------------- Algorithms --------------
+enum Algorithm { ALG_DFS, ALG_BFS, ALG_BEST, ALG_IDA, ALG_BIDIRECTIONAL, ALG_DATABASE, ALG_HDA, ALG_PARALLEL_BFS, ALG_BOUNDED, ALG_ANYTIME };
+
+struct AlgorithmName {
+  const char *name;
+  Algorithm algorithm;
+};
+
+const AlgorithmName algorithmNames[] = {
+  {"dfs", ALG_DFS}, {"bfs", ALG_BFS}, {"best", ALG_BEST}, {"ida", ALG_IDA}, {"bidir", ALG_BIDIRECTIONAL}, {"db", ALG_DATABASE},
+  {"hda", ALG_HDA}, {"pbfs", ALG_PARALLEL_BFS}, {"bounded", ALG_BOUNDED},
+  {"anytime", ALG_ANYTIME},
+};
+
+// Looks up an algorithm by its command-line name, false if unknown
+bool parseAlgorithm(const string &name, Algorithm &algorithm) {
+  for (const AlgorithmName &entry : algorithmNames) {
+    if (name == entry.name) {
+      algorithm = entry.algorithm;
+      return true;
+    }
+  }
+  return false;
+}
+
+// Solves one puzzle with the chosen algorithm into moves, without building
+// the path of states. The database is only used by ALG_DATABASE, and may be
+// nullptr for the other algorithms; searchThreads only by ALG_HDA and ALG_PARALLEL_BFS and budget only by
+// ALG_BOUNDED. Returns false if no path was found.
+bool solvePuzzle(Algorithm algorithm, int heuristicType, const State &state, const DistanceDatabase *database,
+                 MoveSequence &moves, int searchThreads = 1, const SearchBudget &budget = SearchBudget()) {
+  switch (algorithm) {
+    case ALG_DFS:
+      return depthFirstSearch(state, moves);
+    case ALG_BFS:
+      return breadthFirstSearch(state, moves);
+    case ALG_BEST:
+      return bestFirstSearch(state, heuristicType, moves);
+    case ALG_IDA:
+      return idaStarSearch(state, heuristicType, moves);
+    case ALG_BIDIRECTIONAL:
+      return bidirectionalSearch(state, moves);
+    case ALG_DATABASE:
+      if (database == nullptr) break;
+      return distanceDatabaseSearch(state, *database, moves);
+    case ALG_HDA:
+      return parallelBestFirstSearch(state, heuristicType, searchThreads, moves);
+    case ALG_PARALLEL_BFS:
+      return parallelBreadthFirstSearch(state, searchThreads, moves);
+    case ALG_BOUNDED:
+      return boundedBestFirstSearch(state, heuristicType, budget, moves);
+    case ALG_ANYTIME:
+      break;                                                              // Solved by solveGenericLine, which reports the bound
+  }
+  moves.clear();
+  return false;
+}
+
+// Parses a line of cells tiles, false unless it is a permutation of 0 to cells - 1
+bool parseBoard(const string &line, int tiles[], int cells = 9) {
+  istringstream in(line);
+  uint32_t seen = 0;
+  for (int i = 0; i < cells; ++i) {
+    if (!(in >> tiles[i]) || tiles[i] < 0 || tiles[i] >= cells || (seen >> tiles[i] & 1)) return false;
+    seen |= 1u << tiles[i];
+  }
+  string rest;
+  return !(in >> rest);                                                   // Nothing but whitespace may follow
+}
+
+/**
+ * @title Thread Pool
+ * @brief Fixed set of worker threads pulling jobs from a shared queue. The
+ * destructor finishes every queued job before joining the workers.
+ */
+class ThreadPool {
+ public:
+  explicit ThreadPool(int threadCount) {
+    for (int i = 0; i < threadCount; ++i) {
+      workers.emplace_back([this] { workerLoop(); });
+    }
+  }
+
+  ~ThreadPool() {
+    {
+      lock_guard<mutex> lock(queueMutex);
+      stopping = true;
+    }
+    queueReady.notify_all();
+    for (thread &worker : workers) worker.join();
+  }
+
+  void submit(function<void()> job) {
+    {
+      lock_guard<mutex> lock(queueMutex);
+      jobs.push_back(move(job));
+    }
+    queueReady.notify_one();
+  }
+
+ private:
+  vector<thread> workers;
+  deque<function<void()>> jobs;
+  mutex queueMutex;
+  condition_variable queueReady;
+  bool stopping = false;
+
+  void workerLoop() {
+    while (true) {
+      function<void()> job;
+      {
+        unique_lock<mutex> lock(queueMutex);
+        queueReady.wait(lock, [this] { return stopping || !jobs.empty(); });
+        if (jobs.empty()) return;                                         // Stopping and nothing left to do
+        job = move(jobs.front());
+        jobs.pop_front();
+      }
+      job();
+    }
+  }
+};
+
+// Command-line options of batch mode
+struct BatchOptions {
+  string input = "-";                                                     // Puzzle file, "-" for stdin
+  Algorithm algorithm = ALG_BEST;
+  int heuristicType = 2;
+  int threads = 0;                                                        // 0 uses every hardware thread
+  int searchThreads = 0;                                                  // Workers of each hda and pbfs search, 0 uses every hardware thread
+  string databasePath = "distances.db";
+  int size = 3;                                                           // Board width and height
+  bool stats = false;                                                     // Append the search statistics as JSON
+  SearchBudget budget;                                                    // Memory of each bounded search
+  size_t cacheEntries = 0;                                                // Boards kept by the solution cache, 0 for no cache
+  string cacheFile;                                                       // Loaded before and saved after the run, if set
+  int deadlineMs = 1000;                                                  // Time each anytime search may take
+  OutputFormat format = OUTPUT_TEXT;
+  OutputContent content = OUTPUT_MOVES;                                   // Moves or boards of every solved line
+  vector<int> goal;                                                       // Goal tiles, empty for the standard goal
+  bool directGoal = false;                                                // No frame maps the goal, lines go to idaStarToGoal
+  bool symmetry = false;                                                  // Solve the canonical board of every line
+
+  bool canonical() const { return !directGoal && (symmetry || !goal.empty()); } // Lines go through canonicalBoard
+};
+
+const size_t defaultCacheEntries = size_t(1) << 20;                       // Cache size when only --cache-file is given
+
+// One line of input and, once a worker is done with it, its result
+struct BatchSlot {
+  string line;
+  size_t number;                                                          // Line number in the input, blank lines included
+  BatchResult result;
+  bool ready = false;
+};
+
+// Prints the command-line usage of batch mode
+void printBatchUsage() {
+  cout << "Usage: puzzle --batch [file|-] [--algorithm dfs|bfs|best|ida|bidir|db|hda|pbfs|bounded|anytime]\n"
+          "              [--heuristic 1|2|3|4] [--threads N] [--search-threads N] [--db distances.db]\n"
+          "              [--pdb patterns.pdb] [--size 3|4|5] [--memory-budget BYTES[K|M|G]] [--node-budget N]\n"
+          "              [--cache N] [--cache-file solutions.cache] [--deadline-ms N] [--stats]\n"
+          "              [--output moves|boards] [--format text|binary] [--goal \"TILES\"] [--symmetry]\n"
+          "Reads one puzzle per line (size * size numbers, 0 is the blank) and prints one tab-separated line per\n"
+          "puzzle, in input order: line number, status, number of moves, microseconds, moves (U/D/L/R\n"
+          "give the direction the blank moves in) and, with --stats, the search statistics as JSON.\n"
+          "--output boards prints every board along the path instead of the moves, and --format binary\n"
+          "writes fixed-layout records instead of text lines.\n"
+          "--cache keeps the optimal solutions of the last N boards seen, suffixes included, and --cache-file\n"
+          "persists them between runs. anytime lines add the proven suboptimality bound of their path.\n"
+          "--goal solves every line for another goal, given like a board, and --symmetry lets rotated and\n"
+          "reflected boards share their solves and cache entries. A goal whose blank no rotation or reflection\n"
+          "brings onto the standard goal's blank is solved for directly by IDA*, with heuristic 1 or else the\n"
+          "Manhattan distance, and without the cache.\n";
+}
+
+// Parses a size such as 65536, 512K or 2G, false if it is not one
+bool parseByteSize(const string &text, size_t &bytes) {
+  char *end;
+  unsigned long long value = strtoull(text.c_str(), &end, 10);
+  if (end == text.c_str() || value == 0) return false;
+  string unit = end;
+  int shift = unit == "" ? 0 : unit == "K" ? 10 : unit == "M" ? 20 : unit == "G" ? 30 : -1;
+  if (shift < 0) return false;
+  bytes = size_t(value) << shift;
+  return true;
+}
+
+// Parses the batch mode flags, false (after printing usage) on bad input
+bool parseBatchOptions(int argc, char *argv[], BatchOptions &options) {
+  string goalText;
+  for (int i = 1; i < argc; ++i) {
+    string flag = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (flag == "--batch") {
+      if (hasValue && argv[i + 1][0] != '-') options.input = argv[++i];
+      else if (hasValue && string(argv[i + 1]) == "-") ++i;
+    } else if (flag == "--algorithm" && hasValue) {
+      if (!parseAlgorithm(argv[++i], options.algorithm)) {
+        cout << "Unknown algorithm: " << argv[i] << "\n";
+        printBatchUsage();
+        return false;
+      }
+    } else if (flag == "--heuristic" && hasValue) {
+      options.heuristicType = atoi(argv[++i]);
+      if (options.heuristicType < 1 || options.heuristicType > 4) {
+        cout << "The heuristic must be 1, 2, 3 or 4\n";
+        return false;
+      }
+    } else if (flag == "--threads" && hasValue) {
+      options.threads = atoi(argv[++i]);
+    } else if (flag == "--search-threads" && hasValue) {
+      options.searchThreads = atoi(argv[++i]);
+    } else if (flag == "--size" && hasValue) {
+      options.size = atoi(argv[++i]);                                     // Accepts "4" as well as "4x4"
+      if (options.size < 3 || options.size > 5) {
+        cout << "The board size must be 3, 4 or 5\n";
+        return false;
+      }
+    } else if (flag == "--pdb" && hasValue) {
+      patternDatabasePath = argv[++i];                                    // Used by heuristic 4 instead of building the tables
+    } else if (flag == "--db" && hasValue) {
+      options.databasePath = argv[++i];
+    } else if (flag == "--memory-budget" && hasValue) {
+      if (!parseByteSize(argv[++i], options.budget.bytes)) {
+        cout << "The memory budget must be a number of bytes, optionally followed by K, M or G\n";
+        return false;
+      }
+    } else if (flag == "--node-budget" && hasValue) {
+      options.budget.nodes = strtoull(argv[++i], nullptr, 10);
+      if (options.budget.nodes == 0) {
+        cout << "The node budget must be at least 1\n";
+        return false;
+      }
+    } else if (flag == "--cache" && hasValue) {
+      options.cacheEntries = strtoull(argv[++i], nullptr, 10);
+    } else if (flag == "--cache-file" && hasValue) {
+      options.cacheFile = argv[++i];
+    } else if (flag == "--deadline-ms" && hasValue) {
+      options.deadlineMs = atoi(argv[++i]);
+      if (options.deadlineMs < 1) {
+        cout << "The deadline must be at least 1 ms\n";
+        return false;
+      }
+    } else if (flag == "--output" && hasValue) {
+      string content = argv[++i];
+      if (content != "moves" && content != "boards") {
+        cout << "The output must be moves or boards\n";
+        return false;
+      }
+      options.content = content == "moves" ? OUTPUT_MOVES : OUTPUT_BOARDS;
+    } else if (flag == "--format" && hasValue) {
+      string format = argv[++i];
+      if (format != "text" && format != "binary") {
+        cout << "The format must be text or binary\n";
+        return false;
+      }
+      options.format = format == "text" ? OUTPUT_TEXT : OUTPUT_BINARY;
+    } else if (flag == "--goal" && hasValue) {
+      goalText = argv[++i];
+    } else if (flag == "--symmetry") {
+      options.symmetry = true;
+    } else if (flag == "--stats") {
+      options.stats = true;
+    } else {
+      printBatchUsage();
+      return false;
+    }
+  }
+  if (!patternDatabasePath.empty() && patternDatabaseFileSize(patternDatabasePath) != options.size) {
+    cout << "The pattern database " << patternDatabasePath << " is missing, corrupt or not for " << options.size << "x"
+         << options.size << " boards, write one with build_pattern_db --size " << options.size << "\n";
+    return false;
+  }
+  if (options.size != 3 && options.algorithm != ALG_IDA &&
+      (options.size == 5 ||
+       (options.algorithm != ALG_BEST && options.algorithm != ALG_HDA && options.algorithm != ALG_BOUNDED &&
+        options.algorithm != ALG_ANYTIME))) {
+    cout << "Only ida solves 5x5 boards, and only best, hda, bounded, anytime and ida solve 4x4 boards\n";
+    return false;
+  }
+  if (!goalText.empty()) {
+    int cells = options.size * options.size;
+    options.goal.resize(cells);
+    if (!parseBoard(goalText, options.goal.data(), cells)) {
+      cout << "The goal must be a board of the same size, every tile from 0 to " << cells - 1 << " once\n";
+      return false;
+    }
+    options.directGoal = !(options.size == 3   ? goalHasFrame(makeBoard<3, 3>(options.goal.data()))
+                           : options.size == 4 ? goalHasFrame(makeBoard<4, 4>(options.goal.data()))
+                                               : goalHasFrame(makeBoard<5, 5>(options.goal.data())));
+  }
+  if (options.stats && options.format == OUTPUT_BINARY) {
+    cout << "The statistics are only written in the text format\n";
+    return false;
+  }
+  if (!options.cacheFile.empty() && options.cacheEntries == 0) options.cacheEntries = defaultCacheEntries;
+  if (options.directGoal && (options.symmetry || options.cacheEntries > 0)) {
+    cout << "--symmetry and the cache need a goal whose blank a rotation or reflection brings onto the standard goal's blank\n";
+    return false;
+  }
+  bool heuristicSearch = options.algorithm == ALG_BEST || options.algorithm == ALG_IDA || options.algorithm == ALG_HDA ||
+                         options.algorithm == ALG_BOUNDED || options.algorithm == ALG_ANYTIME;
+  if (options.cacheEntries > 0 && (options.size == 5 || options.algorithm == ALG_DFS || options.algorithm == ALG_ANYTIME ||
+                                   (heuristicSearch && options.heuristicType == 3))) {
+    cout << "The cache only holds optimal solutions of 3x3 and 4x4 boards, which dfs, anytime and heuristic 3 do not give\n";
+    return false;
+  }
+  if (options.searchThreads <= 0) options.searchThreads = max(1u, thread::hardware_concurrency());
+  return true;
+}
+
+// A*, HDA*, bounded or anytime search where the board fits a packed key,
+// otherwise a failed solve. bound is only set by the anytime search.
+template <int W, int H>
+bool aStarIfPacked(const Board<W, H> &board, const BatchOptions &options, vector<int> &blankPath, double &bound) {
+  if constexpr (W * H <= 16) {
+    if (options.algorithm == ALG_ANYTIME) {
+      return anytimeAStar(board, options.heuristicType, stopAfter(chrono::milliseconds(options.deadlineMs)), blankPath, bound);
+    }
+    if (options.algorithm == ALG_HDA) return parallelAStar(board, options.heuristicType, options.searchThreads, blankPath);
+    if (options.algorithm == ALG_BOUNDED) return boundedSearch(board, options.heuristicType, options.budget, blankPath);
+    return aStar(board, options.heuristicType, blankPath);
+  } else {
+    return false;
+  }
+}
+
+// Fills blankPath from the cache if it holds the board, false otherwise
+template <int W, int H>
+bool lookupCached(SolutionCache *cache, const Board<W, H> &board, vector<int> &blankPath) {
+  if constexpr (W * H <= 16) {
+    return cache != nullptr && cache->lookup(packBoardKey(board), blankPath);
+  } else {
+    return false;
+  }
+}
+
+// Adds an optimal solution to the cache, if there is one
+template <int W, int H>
+void storeCached(SolutionCache *cache, const Board<W, H> &board, const vector<int> &blankPath) {
+  if constexpr (W * H <= 16) {
+    if (cache != nullptr) cache->insert(packBoardKey(board), board.blank, blankPath);
+  }
+}
+
+// Replaces the tiles of a parsed line by its canonical board for the run's
+// goal (symmetry.h), and sets frame to map the solution back
+template <int W, int H>
+void canonicalizeTiles(const BatchOptions &options, int tiles[], BoardFrame &frame) {
+  Board<W, H> goal = options.goal.empty() ? goalBoard<W, H>() : makeBoard<W, H>(options.goal.data());
+  Board<W, H> canonical;
+  canonicalBoard(makeBoard<W, H>(tiles), goal, canonical, frame);         // The goal was checked with the options
+  copy(canonical.tiles, canonical.tiles + W * H, tiles);
+}
+
+// Solves one input line of a W x H board with the generic engines
+template <int W, int H>
+void solveGenericLine(const BatchOptions &options, SolutionCache *cache, const string &line, BatchResult &result) {
+  int tiles[W * H];
+  if (!parseBoard(line, tiles, W * H)) {
+    result.status = RESULT_INVALID;
+    return;
+  }
+  copy(tiles, tiles + W * H, result.tiles);
+  BoardFrame frame;
+  if (options.canonical()) canonicalizeTiles<W, H>(options, tiles, frame);
+  Board<W, H> board = makeBoard<W, H>(tiles);
+  if (!isBoardSolvable(board)) {
+    result.status = RESULT_UNSOLVABLE;
+    return;
+  }
+
+  auto start = chrono::steady_clock::now();
+  vector<int> blankPath;
+  double bound = 1;
+  bool found = lookupCached(cache, board, blankPath);
+  if (!found) {
+    if (options.algorithm == ALG_IDA) found = idaStar(board, options.heuristicType, blankPath);
+    else found = aStarIfPacked(board, options, blankPath, bound);
+    if (found) storeCached(cache, board, blankPath);
+  }
+  result.micros = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count();
+
+  if (!found) {
+    result.status = RESULT_FAILED;
+    return;
+  }
+  result.status = RESULT_SOLVED;
+  result.moves = MoveSequence::fromBlankPath<W, H>(board.blank, blankPath);
+  if (options.canonical()) result.moves = movesFromFrame<W, H>(result.moves, frame);
+  if (options.algorithm == ALG_ANYTIME) result.bound = bound;
+}
+
+// Solves one input line for a goal no frame maps onto the standard goal,
+// directly against that goal with idaStarToGoal
+template <int W, int H>
+void solveGoalLine(const BatchOptions &options, const string &line, BatchResult &result) {
+  int tiles[W * H];
+  if (!parseBoard(line, tiles, W * H)) {
+    result.status = RESULT_INVALID;
+    return;
+  }
+  copy(tiles, tiles + W * H, result.tiles);
+  Board<W, H> board = makeBoard<W, H>(tiles), goal = makeBoard<W, H>(options.goal.data());
+  if (isBoardSolvable(board) != isBoardSolvable(goal)) {                  // Reachable only within the same parity class
+    result.status = RESULT_UNSOLVABLE;
+    return;
+  }
+
+  auto start = chrono::steady_clock::now();
+  vector<int> blankPath;
+  bool found = idaStarToGoal(board, goal, options.heuristicType, blankPath);
+  result.micros = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count();
+  if (!found) {
+    result.status = RESULT_FAILED;
+    return;
+  }
+  result.status = RESULT_SOLVED;
+  result.moves = MoveSequence::fromBlankPath<W, H>(board.blank, blankPath);
+  if (options.algorithm == ALG_ANYTIME) result.bound = 1;                 // The path is optimal
+}
+
+// Solves one input line into its result, without the statistics
+void solveBatchPuzzle(const BatchOptions &options, const DistanceDatabase &database, SolutionCache *cache, const string &line,
+                      BatchResult &result) {
+  if (options.directGoal) {                                               // No shared tables for this goal
+    if (options.size == 3) solveGoalLine<3, 3>(options, line, result);
+    else if (options.size == 4) solveGoalLine<4, 4>(options, line, result);
+    else solveGoalLine<5, 5>(options, line, result);
+    return;
+  }
+  if (options.size != 3 || options.algorithm == ALG_ANYTIME) {             // Generic engines only
+    if (options.size == 3) solveGenericLine<3, 3>(options, cache, line, result);
+    else if (options.size == 4) solveGenericLine<4, 4>(options, cache, line, result);
+    else solveGenericLine<5, 5>(options, cache, line, result);
+    return;
+  }
+  int tiles[9];
+  if (!parseBoard(line, tiles)) {
+    result.status = RESULT_INVALID;
+    return;
+  }
+  copy(tiles, tiles + 9, result.tiles);
+  BoardFrame frame;
+  if (options.canonical()) canonicalizeTiles<3, 3>(options, tiles, frame);
+  State state(tiles);
+  if (!isSolvable(state)) {
+    result.status = RESULT_UNSOLVABLE;
+    return;
+  }
+
+  auto start = chrono::steady_clock::now();
+  Board<3, 3> board = makeBoard<3, 3>(tiles);
+  vector<int> blankPath;
+  bool found = lookupCached(cache, board, blankPath);
+  if (found) {
+    result.moves = MoveSequence::fromBlankPath<3, 3>(board.blank, blankPath);
+  } else {
+    found = solvePuzzle(options.algorithm, options.heuristicType, state, &database, result.moves, options.searchThreads,
+                        options.budget);
+    if (found && cache != nullptr) storeCached(cache, board, result.moves.toBlankPath<3, 3>(board.blank));
+  }
+  result.micros = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count();
+  result.status = found ? RESULT_SOLVED : RESULT_FAILED;
+  if (found && options.canonical()) result.moves = movesFromFrame<3, 3>(result.moves, frame);
+}
+
+// Solves one input line into its result, statistics included if asked for
+BatchResult solveBatchLine(const BatchOptions &options, const DistanceDatabase &database, SolutionCache *cache,
+                           const string &line) {
+  startStats();                                                           // Lines that never reach a search report zeros
+  BatchResult result;
+  solveBatchPuzzle(options, database, cache, line, result);
+  if (options.stats) result.stats = searchStats.toJson();
+  return result;
+}
+
+/**
+ * @title Batch Mode
+ * @brief Reads puzzles line by line and hands each one to the thread pool.
+ * Results are written in input order as soon as every earlier line is done,
+ * and at most a bounded window of lines is in flight, so arbitrarily long
+ * inputs are streamed with constant memory.
+ *
+ * @param options The parsed command-line options.
+ * @return The process exit code.
+ */
+int runBatch(const BatchOptions &options) {
+  ios::sync_with_stdio(false);
+  DistanceDatabase database;
+  if (options.algorithm == ALG_DATABASE && !database.open(options.databasePath)) {
+    cout << "Could not open " << options.databasePath << ", create it with build_distance_db first.\n";
+    return 1;
+  }
+
+  ifstream file;
+  if (options.input != "-") {
+    file.open(options.input);
+    if (!file) {
+      cout << "Could not open " << options.input << "\n";
+      return 1;
+    }
+  }
+  istream &in = options.input == "-" ? cin : file;
+
+  unique_ptr<SolutionCache> cache;
+  if (options.cacheEntries > 0) {
+    cache.reset(new SolutionCache(options.size, options.size, options.cacheEntries));
+    ifstream existing(options.cacheFile);
+    if (!options.cacheFile.empty() && existing && !cache->load(options.cacheFile)) {  // A missing file starts a new cache
+      cout << "Could not load " << options.cacheFile << ", it is not a solution cache of " << options.size << "x"
+           << options.size << " boards.\n";
+      return 1;
+    }
+  }
+
+  int threadCount = options.threads > 0 ? options.threads : max(1u, thread::hardware_concurrency());
+  const size_t window = size_t(threadCount) * 256;                        // Lines allowed in flight at once
+
+  deque<unique_ptr<BatchSlot>> pending;                                   // Submitted lines, oldest first
+  mutex slotMutex;
+  condition_variable slotReady;
+  size_t lineNumber = 0;
+  ResultWriter writer(cout, options.format, options.content, options.size, options.size);
+
+  auto flush = [&](size_t keep) {                                         // Writes finished lines until at most keep are left
+    unique_lock<mutex> lock(slotMutex);
+    while (!pending.empty()) {
+      if (!pending.front()->ready) {
+        if (pending.size() <= keep) break;
+        writer.flush();                                                  // Hand out what is done before blocking
+        slotReady.wait(lock, [&] { return pending.front()->ready; });
+      }
+      writer.write(pending.front()->number, pending.front()->result);
+      pending.pop_front();
+    }
+  };
+
+  {
+    ThreadPool pool(threadCount);
+    string line;
+    while (getline(in, line)) {
+      ++lineNumber;                                                       // Physical lines, blank ones included
+      if (line.find_first_not_of(" \t\r") == string::npos) continue;      // Skip blank lines
+      BatchSlot *slot;
+      {
+        lock_guard<mutex> lock(slotMutex);
+        pending.push_back(unique_ptr<BatchSlot>(new BatchSlot()));
+        slot = pending.back().get();
+      }
+      slot->line = line;
+      slot->number = lineNumber;
+      pool.submit([&, slot] {
+        BatchResult result = solveBatchLine(options, database, cache.get(), slot->line);
+        {
+          lock_guard<mutex> lock(slotMutex);
+          slot->result = move(result);
+          slot->ready = true;
+        }
+        slotReady.notify_all();
+      });
+      flush(window);
+    }
+    flush(0);
+  }
+  writer.flush();
+  if (cache && !options.cacheFile.empty() && !cache->save(options.cacheFile)) {
+    cout << "Could not write the solution cache to " << options.cacheFile << "\n";
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,223 @@
+// Reproducible benchmark of the search engines over a seeded corpus of
+// solvable boards bucketed by optimal depth. Each run is forked into its own
+// process so its peak RSS is measured alone, and one tab-separated row is
+// printed per run. The pattern database is built before the runs fork and
+// every run is timed on its second search, so no row pays for a cold start.
+// Usage: benchmark [--depths 4,8,...] [--per-depth N] [--seed S]
+//                  [--algorithms dfs,bfs,best1,best2,best3,best4]
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <random>
+#include <sstream>
+#include <string>
+
+#include "distance_db.h"
+#include "functions.h"
+
+using namespace std;
+
+// -------------- Benchmark Setup --------------
+struct BenchmarkAlgorithm {
+  const char *name;
+  int heuristicType;                                                      // 0 for the uninformed searches
+};
+
+const BenchmarkAlgorithm benchmarkAlgorithms[] = {
+  {"dfs", 0}, {"bfs", 0}, {"best1", 1}, {"best2", 2}, {"best3", 3}, {"best4", 4},
+};
+
+struct BenchmarkOptions {
+  vector<int> depths = {4, 8, 12, 16, 20, 24, 28};
+  int perDepth = 5;                                                       // Boards sampled for each depth
+  uint64_t seed = 1;
+  vector<BenchmarkAlgorithm> algorithms;
+};
+
+struct BenchmarkBoard {
+  PackedState state;
+  int depth;                                                              // Optimal number of moves
+};
+
+struct RunResult {                                                        // Sent from the forked run back to the parent
+  double seconds;
+  uint64_t nodes;
+  int pathLength;                                                         // -1 when no path was found
+};
+
+void printBenchmarkUsage() {
+  cout << "Usage: benchmark [--depths 4,8,...] [--per-depth N] [--seed S]\n"
+          "                 [--algorithms dfs,bfs,best1,best2,best3,best4]" << endl;
+}
+
+// Splits a comma-separated list
+vector<string> splitList(const string &list) {
+  vector<string> items;
+  stringstream stream(list);
+  string item;
+  while (getline(stream, item, ',')) items.push_back(item);
+  return items;
+}
+
+// Parses the command line, false (after printing why) on bad arguments
+bool parseBenchmarkOptions(int argc, char *argv[], BenchmarkOptions &options) {
+  for (int i = 1; i < argc; ++i) {
+    string flag = argv[i];
+    if (i + 1 >= argc) {
+      cout << "Missing value for " << flag << endl;
+      return false;
+    }
+    string value = argv[++i];
+    if (flag == "--depths") {
+      options.depths.clear();
+      for (const string &item : splitList(value)) {
+        int depth = atoi(item.c_str());
+        if (depth < 0 || depth > int(dbDistanceMask)) {
+          cout << "Depths must be between 0 and " << int(dbDistanceMask) << endl;
+          return false;
+        }
+        options.depths.push_back(depth);
+      }
+    } else if (flag == "--per-depth") {
+      options.perDepth = atoi(value.c_str());
+      if (options.perDepth < 1) {
+        cout << "--per-depth must be at least 1" << endl;
+        return false;
+      }
+    } else if (flag == "--seed") {
+      options.seed = strtoull(value.c_str(), nullptr, 10);
+    } else if (flag == "--algorithms") {
+      options.algorithms.clear();
+      for (const string &item : splitList(value)) {
+        bool known = false;
+        for (const BenchmarkAlgorithm &algorithm : benchmarkAlgorithms) {
+          if (item == algorithm.name) {
+            options.algorithms.push_back(algorithm);
+            known = true;
+          }
+        }
+        if (!known) {
+          cout << "Unknown algorithm " << item << endl;
+          return false;
+        }
+      }
+    } else {
+      cout << "Unknown option " << flag << endl;
+      return false;
+    }
+  }
+  if (options.algorithms.empty()) options.algorithms.assign(begin(benchmarkAlgorithms), end(benchmarkAlgorithms));
+  return true;
+}
+
+/**
+ * @title Benchmark Corpus
+ * @brief Samples boards of each requested optimal depth. Distances come from
+ * the same retrograde search the distance database uses, candidates are taken
+ * in rank order and picked by a partial Fisher-Yates shuffle driven by
+ * mt19937_64, whose output is fixed by the standard, so a seed names the same
+ * corpus on every platform.
+ */
+vector<BenchmarkBoard> buildCorpus(const BenchmarkOptions &options) {
+  vector<uint8_t> entries;
+  buildDistanceTable(entries);
+  mt19937_64 random(options.seed);
+
+  vector<BenchmarkBoard> corpus;
+  for (int depth : options.depths) {
+    vector<uint32_t> candidates;
+    for (uint32_t rank = 0; rank < stateCount; ++rank) {
+      if (entries[rank] != dbUnreachable && (entries[rank] & dbDistanceMask) == depth) candidates.push_back(rank);
+    }
+    size_t picks = min(candidates.size(), size_t(options.perDepth));
+    for (size_t i = 0; i < picks; ++i) {
+      swap(candidates[i], candidates[i + random() % (candidates.size() - i)]);
+      corpus.push_back({unrankPacked(candidates[i]), depth});
+    }
+  }
+  return corpus;
+}
+
+// Runs one search in the calling process
+RunResult runSearch(const BenchmarkAlgorithm &algorithm, PackedState board) {
+  State initial = unpackState(board);
+  auto start = chrono::steady_clock::now();
+  vector<State> path;
+  if (algorithm.heuristicType > 0) path = bestFirstSearch(initial, algorithm.heuristicType);
+  else if (string(algorithm.name) == "dfs") path = depthFirstSearch(initial);
+  else path = breadthFirstSearch(initial);
+  double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+  return {seconds, searchStats.nodesExpanded, path.empty() ? -1 : int(path.size()) - 1};
+}
+
+// Runs one search in a child process, false if it did not report back. A
+// first, untimed search grows the child's search storage (SearchContext) to
+// the size the timed one needs. peakKilobytes is the child's maximum
+// resident set size.
+bool runForked(const BenchmarkAlgorithm &algorithm, PackedState board, RunResult &result, long &peakKilobytes) {
+  int channel[2];
+  if (pipe(channel) != 0) return false;
+  pid_t child = fork();
+  if (child < 0) {
+    close(channel[0]);
+    close(channel[1]);
+    return false;
+  }
+  if (child == 0) {
+    close(channel[0]);
+    runSearch(algorithm, board);                                          // Warm-up
+    RunResult measured = runSearch(algorithm, board);
+    bool written = write(channel[1], &measured, sizeof(measured)) == ssize_t(sizeof(measured));
+    _exit(written ? 0 : 1);
+  }
+
+  close(channel[1]);
+  bool received = read(channel[0], &result, sizeof(result)) == ssize_t(sizeof(result));
+  close(channel[0]);
+  int status;
+  struct rusage usage;
+  if (wait4(child, &status, 0, &usage) != child) return false;
+  peakKilobytes = usage.ru_maxrss;                                        // Reported in kilobytes on Linux
+  return received && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+// Writes a board as its nine tiles, e.g. 123804765 for the goal
+string boardString(PackedState board) {
+  string text;
+  for (int i = 0; i < 9; ++i) text += char('0' + board.tileAt(i));
+  return text;
+}
+
+int main(int argc, char *argv[]) {
+  BenchmarkOptions options;
+  if (!parseBenchmarkOptions(argc, argv, options)) {
+    printBenchmarkUsage();
+    return 1;
+  }
+  vector<BenchmarkBoard> corpus = buildCorpus(options);
+  defaultPatternDatabase<3, 3>();                                         // Built once, the children inherit it
+
+  cout << "algorithm\tdepth\tboard\tseconds\tnodes\tnodes_per_second\tpeak_rss_kb\tpath_length\n";
+  cout.flush();                                                           // Nothing buffered may be duplicated by fork
+  bool failed = false;
+  for (const BenchmarkAlgorithm &algorithm : options.algorithms) {
+    for (const BenchmarkBoard &board : corpus) {
+      RunResult result;
+      long peakKilobytes = 0;
+      if (!runForked(algorithm, board.state, result, peakKilobytes)) {
+        cerr << "Run failed: " << algorithm.name << " on " << boardString(board.state) << endl;
+        failed = true;
+        continue;
+      }
+      double rate = result.seconds > 0 ? result.nodes / result.seconds : 0;
+      cout << algorithm.name << '\t' << board.depth << '\t' << boardString(board.state) << '\t' << result.seconds << '\t'
+           << result.nodes << '\t' << uint64_t(rate) << '\t' << peakKilobytes << '\t' << result.pathLength << '\n';
+      cout.flush();
+    }
+  }
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,31 @@
+// Offline builder for the all-states distance database used by the
+// "Distance Database Lookup" solver mode.
+// Usage: build_distance_db [output path] (defaults to distances.db)
+
+#include "distance_db.h"
+
+int main(int argc, char *argv[]) {
+  if (argc > 2 || (argc == 2 && argv[1][0] == '-')) {                    // A flag such as --help is not a path
+    cout << "Usage: build_distance_db [output path] (defaults to distances.db)" << endl;
+    return 1;
+  }
+  string path = argc > 1 ? argv[1] : "distances.db";
+
+  vector<uint8_t> entries;
+  buildDistanceTable(entries);
+
+  int maxDistance = 0;
+  uint32_t reachable = 0;
+  for (uint8_t entry : entries) {
+    if (entry == dbUnreachable) continue;
+    ++reachable;
+    maxDistance = max(maxDistance, entry & int(dbDistanceMask));
+  }
+
+  if (!writeDistanceDatabase(path, entries)) {
+    cout << "Could not write the distance database to " << path << endl;
+    return 1;
+  }
+  cout << "Wrote " << reachable << " solvable states (maximum distance " << maxDistance << ") to " << path << endl;
+  return 0;
+}
@@ -0,0 +1,45 @@
+// Offline builder for the additive pattern databases used by heuristic 4.
+// Usage: build_pattern_db [--size 3|4|5] [output path] (defaults to 3 and patterns.pdb)
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+#include "pattern_db.h"
+
+template <int W, int H>
+int buildAndSave(const string &path) {
+  auto start = chrono::steady_clock::now();
+  PatternDatabase<W, H> database;
+  database.build(defaultPartition<W, H>());
+  auto seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+  if (!database.save(path)) {
+    cout << "Could not write the pattern database to " << path << endl;
+    return 1;
+  }
+  cout << "Wrote " << database.patternCount() << " patterns for " << W << "x" << H << " boards to " << path << " in "
+       << seconds << " s" << endl;
+  return 0;
+}
+
+int main(int argc, char *argv[]) {
+  int size = 3;
+  string path = "patterns.pdb";
+  for (int i = 1; i < argc; ++i) {
+    string arg = argv[i];
+    if (arg == "--size" && i + 1 < argc) size = atoi(argv[++i]);
+    else path = arg;
+  }
+
+  switch (size) {
+    case 3:
+      return buildAndSave<3, 3>(path);
+    case 4:
+      return buildAndSave<4, 4>(path);
+    case 5:
+      return buildAndSave<5, 5>(path);
+  }
+  cout << "The board size must be 3, 4 or 5" << endl;
+  return 1;
+}
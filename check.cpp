@@ -0,0 +1,341 @@
+// Consistency checks run by ctest: every engine against the distance table on
+// a seeded sample of boards, the batch heuristic kernels against their scalar
+// versions on every board, and the symmetry, solution cache, external BFS and
+// workload tools against the distance table. Prints one line per check.
+// Usage: check [--samples N] [--seed S]
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <random>
+
+#include "batch.h"
+#include "external_bfs.h"
+#include "workload.h"
+
+using namespace std;
+
+int failures = 0;
+
+// Prints the outcome of a check and counts the failures
+void report(bool passed, const string &what) {
+  cout << (passed ? "ok     " : "FAILED ") << what << endl;
+  if (!passed) ++failures;
+}
+
+// Whether the moves take board to goal, every one of them on the board
+template <int W, int H>
+bool movesReach(Board<W, H> board, const MoveSequence &moves, const Board<W, H> &goal) {
+  for (size_t i = 0; i < moves.size(); ++i) {
+    int next = puzzleTables<W, H>.neighbors[board.blank][moves[i]];
+    if (next < 0) return false;
+    swap(board.tiles[board.blank], board.tiles[next]);
+    board.blank = next;
+  }
+  return board == goal;
+}
+
+// Optimal distance of a packed 8-puzzle board, read from the distance table
+int tableDistance(const vector<uint8_t> &entries, PackedState board) { return entries[rankPacked(board)] & dbDistanceMask; }
+
+// Packs an 8-puzzle board
+PackedState packBoard(const Board<3, 3> &board) {
+  int tiles[9];
+  copy(board.tiles, board.tiles + 9, tiles);
+  return packBoard(tiles);
+}
+
+// -------------- Heuristic Kernels --------------
+// Every batch kernel against the scalar functions of functions.h on all 9!
+// boards, solvable or not, in batches of odd size so the vector loops and
+// their scalar tails both run
+void checkKernels() {
+  const size_t chunk = 1023;
+  vector<PackedState> boards(chunk);
+  int manhattan[chunk], misplaced[chunk], sequence[chunk], combined[chunk];
+  bool solvable[chunk];
+  uint32_t mismatches = 0;
+  for (uint32_t first = 0; first < stateCount; first += chunk) {
+    size_t count = min(size_t(stateCount - first), chunk);
+    for (size_t i = 0; i < count; ++i) boards[i] = unrankPacked(first + i);
+    batchManhattan(boards.data(), count, manhattan);
+    batchMisplaced(boards.data(), count, misplaced);
+    batchSequenceScore(boards.data(), count, sequence);
+    batchSolvable(boards.data(), count, solvable);
+    batchHeuristic(boards.data(), count, 3, combined);
+    for (size_t i = 0; i < count; ++i) {
+      State state = unpackState(boards[i]);
+      mismatches += manhattan[i] != cManDist(state) || misplaced[i] != cTilesOutOfPlace(state) ||
+                    sequence[i] != cSeqScore(state) || solvable[i] != isSolvable(state) ||
+                    combined[i] != cHeuristicH(state);
+    }
+  }
+  report(mismatches == 0, "batch kernels match the scalar heuristics on all " + to_string(stateCount) + " boards");
+}
+
+// -------------- Engines --------------
+struct EngineCase {
+  const char *name;
+  Algorithm algorithm;
+  int heuristicType;
+  bool optimal;                                                           // false for dfs and the inadmissible heuristic 3
+};
+
+const EngineCase engineCases[] = {
+  {"dfs", ALG_DFS, 0, false},        {"bfs", ALG_BFS, 0, true},           {"best h1", ALG_BEST, 1, true},
+  {"best h2", ALG_BEST, 2, true},    {"best h3", ALG_BEST, 3, false},     {"best h4", ALG_BEST, 4, true},
+  {"ida h1", ALG_IDA, 1, true},      {"ida h2", ALG_IDA, 2, true},        {"ida h4", ALG_IDA, 4, true},
+  {"bidir", ALG_BIDIRECTIONAL, 0, true}, {"db", ALG_DATABASE, 0, true},   {"hda h2", ALG_HDA, 2, true},
+  {"hda h4", ALG_HDA, 4, true},      {"pbfs", ALG_PARALLEL_BFS, 0, true}, {"bounded h2", ALG_BOUNDED, 2, true},
+};
+
+// Solves every sampled board with every engine: each path must be legal and
+// end on the goal, and the optimal engines must match the table's distance.
+// The bounded search gets a node budget most samples exceed, so that its
+// IDA* fallback is checked too.
+void checkEngines(const vector<uint8_t> &entries, const vector<PackedState> &sample) {
+  DistanceDatabase database;
+  database.build();
+  SearchBudget budget;
+  budget.nodes = 2000;
+  const Board<3, 3> goal = goalBoard<3, 3>();
+  for (const EngineCase &engine : engineCases) {
+    int wrong = 0;
+    for (PackedState board : sample) {
+      MoveSequence moves;
+      State state = unpackState(board);
+      bool found = solvePuzzle(engine.algorithm, engine.heuristicType, state, &database, moves, 2, budget);
+      bool legal = found && movesReach(makeBoard<3, 3>(state.board), moves, goal);
+      wrong += !legal || (engine.optimal && int(moves.size()) != tableDistance(entries, board));
+    }
+    report(wrong == 0, string(engine.name) + (engine.optimal ? " finds optimal paths" : " finds legal paths") + " on " +
+                           to_string(sample.size()) + " boards");
+  }
+
+  int wrong = 0;                                                          // ARA*, optimal once its bound reaches 1
+  for (PackedState board : sample) {
+    MoveSequence moves;
+    double bound;
+    State state = unpackState(board);
+    bool found = anytimeBestFirstSearch(state, 2, chrono::milliseconds(5000), bound, moves);
+    bool legal = found && movesReach(makeBoard<3, 3>(state.board), moves, goal);
+    wrong += !legal || bound < 1 || (bound == 1 && int(moves.size()) != tableDistance(entries, board));
+  }
+  report(wrong == 0, "anytime finds legal paths within its bound on " + to_string(sample.size()) + " boards");
+}
+
+// -------------- Symmetry --------------
+// Solves each sampled board for another goal through its canonical board: the
+// moves mapped back must take the board to that goal, in the optimal number
+// of moves, and the frame must take that goal to the standard one
+void checkSymmetry(const vector<uint8_t> &entries, const vector<PackedState> &sample, mt19937_64 &random) {
+  int wrong = 0;
+  for (PackedState packed : sample) {
+    int tiles[9];
+    unpackBoard(packed, tiles);
+    Board<3, 3> board = makeBoard<3, 3>(tiles);
+    int goalTiles[9];
+    unpackBoard(sample[random() % sample.size()], goalTiles);             // Relabeled so its blank sits in the center
+    int center = puzzleTables<3, 3>.blankGoal;
+    swap(goalTiles[center], *find(goalTiles, goalTiles + 9, 0));
+    Board<3, 3> goal = makeBoard<3, 3>(goalTiles);
+
+    Board<3, 3> canonical;
+    BoardFrame frame;
+    MoveSequence moves;
+    bool mapped = canonicalBoard(board, goal, canonical, frame) && toFrame(goal, frame) == goalBoard<3, 3>();
+    bool solvable = mapped && isBoardSolvable(canonical);
+    if (solvable) idaStarSearch(unpackState(packBoard(canonical)), 2, moves);
+    MoveSequence original = movesFromFrame<3, 3>(moves, frame);
+    wrong += !mapped || (solvable && (!movesReach(board, original, goal) ||
+                                      int(original.size()) != tableDistance(entries, packBoard(canonical))));
+  }
+  report(wrong == 0, "canonical boards solve " + to_string(sample.size()) + " boards for other goals");
+
+  wrong = 0;                                                              // Goals whose blank no frame brings to the center
+  for (PackedState packed : sample) {
+    int tiles[9];
+    unpackBoard(packed, tiles);
+    Board<3, 3> board = makeBoard<3, 3>(tiles);
+    int goalTiles[9];
+    unpackBoard(sample[random() % sample.size()], goalTiles);
+    int cell = random() % 8;                                              // Any cell but the center
+    if (cell >= puzzleTables<3, 3>.blankGoal) ++cell;
+    swap(goalTiles[cell], *find(goalTiles, goalTiles + 9, 0));
+    int first = cell == 0 ? 1 : 0, second = cell == 8 ? 7 : 8;            // Two tiles, to switch the goal's parity
+    if (isBoardSolvable(makeBoard<3, 3>(goalTiles)) != isBoardSolvable(board)) swap(goalTiles[first], goalTiles[second]);
+    Board<3, 3> goal = makeBoard<3, 3>(goalTiles);
+
+    vector<int> misplacedPath, manhattanPath, unreachedPath;
+    bool found = idaStarToGoal(board, goal, 1, misplacedPath) && idaStarToGoal(board, goal, 2, manhattanPath);
+    swap(goalTiles[first], goalTiles[second]);
+    bool unreached = !idaStarToGoal(board, makeBoard<3, 3>(goalTiles), 2, unreachedPath);
+    wrong += goalHasFrame(goal) || !found || !unreached || misplacedPath.size() != manhattanPath.size() ||
+             !movesReach(board, MoveSequence::fromBlankPath<3, 3>(board.blank, manhattanPath), goal);
+  }
+  report(wrong == 0, "IDA* solves " + to_string(sample.size()) + " boards for goals with an off-center blank");
+}
+
+// -------------- Solution Cache --------------
+// Walks blankPath from board and returns the board after the first steps moves
+Board<3, 3> walkBlankPath(Board<3, 3> board, const vector<int> &blankPath, size_t steps) {
+  for (size_t i = 0; i < steps; ++i) {
+    swap(board.tiles[board.blank], board.tiles[blankPath[i]]);
+    board.blank = blankPath[i];
+  }
+  return board;
+}
+
+// Overwrites the file with bytes, the first drop bytes of the end removed
+void rewriteFile(const string &path, vector<char> bytes, size_t drop) {
+  bytes.resize(bytes.size() - drop);
+  ofstream(path, ios::binary | ios::trunc).write(bytes.data(), bytes.size());
+}
+
+// Every board along a cached path is answered by its optimal suffix, the
+// least recently used boards go first once the cache is full, and a saved
+// cache loads back while truncated or corrupt copies of its file are refused
+void checkCache(const vector<uint8_t> &entries, const vector<PackedState> &sample) {
+  const Board<3, 3> goal = goalBoard<3, 3>();
+  SolutionCache cache(3, 3, 1 << 16);
+  int wrong = 0;
+  for (PackedState packed : sample) {
+    int tiles[9];
+    unpackBoard(packed, tiles);
+    Board<3, 3> board = makeBoard<3, 3>(tiles);
+    vector<int> blankPath, cached;
+    idaStar(board, 2, blankPath);
+    cache.insert(packBoardKey(board), board.blank, blankPath);
+    for (size_t offset = 0; offset < blankPath.size(); ++offset) {        // Every suffix, from its own board
+      Board<3, 3> suffix = walkBlankPath(board, blankPath, offset);
+      bool hit = cache.lookup(packBoardKey(suffix), cached);
+      wrong += !hit || !movesReach(suffix, MoveSequence::fromBlankPath<3, 3>(suffix.blank, cached), goal) ||
+               int(cached.size()) != tableDistance(entries, packBoard(suffix));
+    }
+  }
+  report(wrong == 0, "the cache answers every board along " + to_string(sample.size()) + " cached paths");
+
+  Board<3, 3> board = goal;                                               // A path of 5 moves or more
+  vector<int> blankPath, cached;
+  for (PackedState packed : sample) {
+    int tiles[9];
+    unpackBoard(packed, tiles);
+    board = makeBoard<3, 3>(tiles);
+    idaStar(board, 2, blankPath);
+    if (blankPath.size() >= 5) break;
+  }
+  size_t n = blankPath.size();
+  Board<3, 3> near = walkBlankPath(board, blankPath, n - 1);              // One move from the goal
+  int other = 0;                                                          // Another board one move from the goal
+  while (puzzleTables<3, 3>.neighbors[goal.blank][other] < 0 ||
+         walkBlankPath(goal, {puzzleTables<3, 3>.neighbors[goal.blank][other]}, 1) == near) {
+    ++other;
+  }
+  Board<3, 3> otherBoard = walkBlankPath(goal, {puzzleTables<3, 3>.neighbors[goal.blank][other]}, 1);
+  SolutionCache small(3, 3, 3);
+  small.insert(packBoardKey(board), board.blank, blankPath);              // Keeps the last 3 boards of the path
+  bool evicted = small.size() == 3 && !small.lookup(packBoardKey(board), cached) &&
+                 small.lookup(packBoardKey(walkBlankPath(board, blankPath, n - 3)), cached); // Now the most recent
+  small.insert(packBoardKey(otherBoard), otherBoard.blank, {goal.blank}); // Evicts the least recent, n - 2
+  evicted = evicted && small.size() == 3 && small.lookup(packBoardKey(walkBlankPath(board, blankPath, n - 3)), cached) &&
+            !small.lookup(packBoardKey(walkBlankPath(board, blankPath, n - 2)), cached) &&
+            small.lookup(packBoardKey(otherBoard), cached);
+  report(evicted, "the cache evicts the least recently used boards");
+
+  const string path = "check.cache";
+  SolutionCache loaded(3, 3, 1 << 16);
+  bool reloaded = cache.save(path) && loaded.load(path) && loaded.size() == cache.size();
+  for (PackedState packed : sample) {
+    int tiles[9];
+    unpackBoard(packed, tiles);
+    Board<3, 3> start = makeBoard<3, 3>(tiles);
+    reloaded = reloaded && loaded.lookup(packBoardKey(start), cached) &&
+               int(cached.size()) == tableDistance(entries, packed);
+  }
+  report(reloaded, "a saved cache loads back with the same paths");
+
+  ifstream in(path, ios::binary);
+  vector<char> bytes((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+  in.close();
+  rewriteFile(path, bytes, 1);                                            // Last path cut short
+  bool refused = !SolutionCache(3, 3, 16).load(path);
+  vector<char> corrupt = bytes;
+  corrupt.back() = char(0xFF);                                            // Last move off the board
+  rewriteFile(path, corrupt, 0);
+  refused = refused && !SolutionCache(3, 3, 16).load(path);
+  corrupt.back() = 0;                                                     // Last move ends with the blank off its goal cell
+  rewriteFile(path, corrupt, 0);
+  refused = refused && !SolutionCache(3, 3, 16).load(path);
+  report(refused, "truncated and corrupt cache files are refused");
+  remove(path.c_str());
+}
+
+// -------------- External BFS and Workloads --------------
+// Counts the 8-puzzle's layers on disk with a small memory budget, then draws
+// a workload from the distance file it wrote and from the in-memory index:
+// the layer sizes and every drawn depth must match the table
+void checkExternalSearch(const vector<uint8_t> &entries) {
+  vector<uint64_t> expected;
+  for (uint8_t entry : entries) {
+    if (entry == dbUnreachable) continue;
+    size_t distance = entry & dbDistanceMask;
+    if (expected.size() <= distance) expected.resize(distance + 1, 0);
+    ++expected[distance];
+  }
+
+  ExternalBfsOptions options;
+  options.memoryBytes = size_t(64) << 10;                                 // Many runs per layer, merged in passes
+  options.distancePath = "check.xdb";
+  vector<uint64_t> layerCounts;
+  bool searched = externalBreadthFirstSearch(goalBoard<3, 3>(), options, layerCounts);
+  report(searched && layerCounts == expected, "external BFS counts every layer of the 8-puzzle");
+
+  DepthIndex built, mapped;
+  built.buildEightPuzzle();
+  bool opened = searched && mapped.open(options.distancePath);
+  report(opened, "the external distance file opens as a depth index");
+  for (DepthIndex *index : {&built, &mapped}) {
+    if (index->maxDepth() < 0) continue;
+    vector<uint64_t> weights;
+    if (!parseDepthMix("natural", *index, weights)) continue;
+    WorkloadGenerator generator(*index, weights, 7);
+    int wrong = 0;
+    for (int i = 0; i < 2000; ++i) {
+      int depth;
+      uint64_t key = generator.next(depth);
+      int tiles[9];
+      for (int cell = 0; cell < 9; ++cell) tiles[cell] = (key >> (4 * cell)) & packedCellMask;
+      wrong += tableDistance(entries, packBoard(tiles)) != depth;
+    }
+    report(wrong == 0, string("workload depths match the table, ") + (index == &built ? "built index" : "mapped index"));
+  }
+  remove(options.distancePath.c_str());
+}
+
+int main(int argc, char *argv[]) {
+  size_t samples = 40;
+  uint64_t seed = 1;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    string flag = argv[i];
+    if (flag == "--samples") samples = strtoull(argv[i + 1], nullptr, 10);
+    else if (flag == "--seed") seed = strtoull(argv[i + 1], nullptr, 10);
+  }
+
+  vector<uint8_t> entries;
+  buildDistanceTable(entries);
+  mt19937_64 random(seed);
+  vector<PackedState> sample;                                             // Solvable boards, uniformly
+  while (sample.size() < samples) {
+    uint32_t rank = random() % stateCount;
+    if (entries[rank] != dbUnreachable) sample.push_back(unrankPacked(rank));
+  }
+
+  checkKernels();
+  checkEngines(entries, sample);
+  checkSymmetry(entries, sample, random);
+  checkCache(entries, sample);
+  checkExternalSearch(entries);
+  cout << (failures == 0 ? "All checks passed" : to_string(failures) + " checks failed") << endl;
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,194 @@
+// Precomputed all-states distance database: one retrograde breadth-first
+// search from the goal stores every state's optimal distance and best move,
+// indexed by permutation rank, so solving becomes a table walk.
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "functions.h"
+
+using namespace std;
+
+// -------------- Database Layout --------------
+// A 16-byte header followed by one byte per permutation rank. Each entry holds
+// the optimal distance in bits 0-4 and the best blank move (Up, Down, Left,
+// Right, as in blankMoves) in bits 5-6. Unsolvable boards hold dbUnreachable.
+const char dbMagic[4] = {'8', 'P', 'D', 'B'};                             // File signature
+const uint32_t dbVersion = 1;                                             // Bumped whenever the layout changes
+const uint8_t dbUnreachable = 0xFF;                                       // Entry of a state the goal cannot reach
+const uint8_t dbDistanceMask = 0x1F;                                      // Bits holding the distance
+const int dbMoveShift = 5;                                                // Offset of the best move bits
+
+struct DistanceDbHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t entryCount;
+  uint32_t reserved;
+};
+
+/**
+ * @title Distance Table Builder
+ * @brief Runs a single breadth-first search backwards from the goal over
+ * every solvable state. A state reached from its parent by moving the blank
+ * in direction d is one step further away, and its best move is the opposite
+ * direction (d ^ 1), which slides the blank back towards the goal.
+ *
+ * @param entries Filled with stateCount entries in the database layout.
+ */
+void buildDistanceTable(vector<uint8_t> &entries) {
+  entries.assign(stateCount, dbUnreachable);
+  vector<PackedState> frontier;                                           // Queue of states in order of distance
+  frontier.reserve(stateCount / 2);
+  frontier.push_back(packedGoal);
+  entries[rankPacked(packedGoal)] = 0;
+
+  for (size_t head = 0; head < frontier.size(); ++head) {
+    PackedState state = frontier[head];
+    int distance = entries[rankPacked(state)] & dbDistanceMask;
+    const int8_t *moves = blankMoves[state.blankIndex()];
+    for (int d = 0; d < 4; ++d) {
+      if (moves[d] < 0) continue;
+      PackedState child = applyMove(state, moves[d]);
+      uint32_t childRank = rankPacked(child);
+      if (entries[childRank] != dbUnreachable) continue;                  // Already reached at a smaller or equal distance
+      entries[childRank] = uint8_t((distance + 1) | ((d ^ 1) << dbMoveShift));
+      frontier.push_back(child);
+    }
+  }
+}
+
+// Writes the table to path with its header, returns false on I/O errors
+bool writeDistanceDatabase(const string &path, const vector<uint8_t> &entries) {
+  ofstream out(path, ios::binary | ios::trunc);
+  if (!out) return false;
+  DistanceDbHeader header;
+  memcpy(header.magic, dbMagic, sizeof(dbMagic));
+  header.version = dbVersion;
+  header.entryCount = entries.size();
+  header.reserved = 0;
+  out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  out.write(reinterpret_cast<const char *>(entries.data()), entries.size());
+  return bool(out);
+}
+
+/**
+ * @title Distance Database
+ * @brief Read-only view of a distance table, either memory-mapped from a file
+ * written by build_distance_db or built in memory. Mapping the file makes
+ * startup nearly free and lets the page cache share it between processes.
+ */
+class DistanceDatabase {
+ public:
+  DistanceDatabase() {}
+  DistanceDatabase(const DistanceDatabase &) = delete;
+  DistanceDatabase &operator=(const DistanceDatabase &) = delete;
+  ~DistanceDatabase() { close(); }
+
+  bool isLoaded() const { return entries != nullptr; }
+
+  bool open(const string &path) {                                         // Maps the file, false if missing or invalid
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat info;
+    size_t expected = sizeof(DistanceDbHeader) + stateCount;
+    if (fstat(fd, &info) != 0 || size_t(info.st_size) != expected) {
+      ::close(fd);
+      return false;
+    }
+    void *data = mmap(nullptr, expected, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);                                                          // The mapping stays valid after closing
+    if (data == MAP_FAILED) return false;
+
+    const DistanceDbHeader *header = static_cast<const DistanceDbHeader *>(data);
+    if (memcmp(header->magic, dbMagic, sizeof(dbMagic)) != 0 || header->version != dbVersion ||
+        header->entryCount != stateCount) {
+      munmap(data, expected);
+      return false;
+    }
+    mapping = data;
+    mappingSize = expected;
+    entries = static_cast<const uint8_t *>(data) + sizeof(DistanceDbHeader);
+    return true;
+  }
+
+  void build() {                                                          // Builds the table in memory instead of mapping it
+    close();
+    buildDistanceTable(owned);
+    entries = owned.data();
+  }
+
+  void close() {
+    if (mapping != nullptr) munmap(mapping, mappingSize);
+    mapping = nullptr;
+    mappingSize = 0;
+    owned.clear();
+    entries = nullptr;
+  }
+
+  int distance(PackedState state) const {                                 // Optimal distance, -1 if unsolvable
+    uint8_t entry = entries[rankPacked(state)];
+    return entry == dbUnreachable ? -1 : entry & dbDistanceMask;
+  }
+
+  int bestMove(PackedState state) const {                                 // Best blank direction, index into blankMoves
+    return entries[rankPacked(state)] >> dbMoveShift & 3;
+  }
+
+ private:
+  const uint8_t *entries = nullptr;
+  void *mapping = nullptr;
+  size_t mappingSize = 0;
+  vector<uint8_t> owned;
+};
+
+/**
+ * @title Distance Database Search
+ * @brief Reconstructs an optimal path without searching: starting from the
+ * initial state it repeatedly applies the stored best move, each of which
+ * lowers the distance by exactly one, until the goal is reached. A move that
+ * leaves the board or does not lower the distance by one, as a corrupt file
+ * could store, ends the search.
+ *
+ * @param initialState The initial state of the 8-puzzle game.
+ * @param database A loaded distance database.
+ * @param moves Set to the moves from the initial state to the goal state.
+ * @return false if the state is not solvable, or the database does not lead
+ * it to the goal.
+ */
+bool distanceDatabaseSearch(const State &initialState, const DistanceDatabase &database, MoveSequence &moves) {
+  startStats();
+  moves.clear();
+  PackedState state = packState(initialState);
+  int distance = database.distance(state);
+  if (distance < 0) return false;                                         // No solution exists
+  countStat(searchStats.nodesExpanded, distance);                         // One table lookup per move
+  countStat(searchStats.nodesGenerated, distance);
+
+  for (; distance > 0; --distance) {                                      // Every step is checked, the file may be corrupt
+    int direction = database.bestMove(state);
+    int newBlank = blankMoves[state.blankIndex()][direction];
+    if (newBlank < 0) return false;                                       // The stored move leaves the board
+    PackedState next = applyMove(state, newBlank);
+    if (database.distance(next) != distance - 1) return false;            // The stored move does not get closer
+    moves.push(direction);
+    state = next;
+  }
+  return state == packBoard(puzzleTables<3, 3>.goal);                     // Distance 0 only at the goal
+}
+
+// Distance database search, path of states from the initial state to the goal
+vector<State> distanceDatabaseSearch(const State &initialState, const DistanceDatabase &database) {
+  MoveSequence moves;
+  if (!distanceDatabaseSearch(initialState, database, moves)) return vector<State>();
+  return replayMoves(initialState, moves);
+}
@@ -0,0 +1,67 @@
+// Disk-backed breadth-first enumeration of a puzzle's state space, printing
+// the number of boards at every distance from the start board.
+// Usage: external_bfs [--size 3|4] [--start "TILES"] [--memory BYTES[K|M|G]]
+//                     [--temp DIR] [--max-depth N] [--distances FILE]
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+#include "batch.h"
+#include "external_bfs.h"
+
+template <int W, int H>
+int enumerate(const vector<int> &startTiles, const ExternalBfsOptions &options) {
+  Board<W, H> start = startTiles.empty() ? goalBoard<W, H>() : makeBoard<W, H>(startTiles.data());
+  auto begin = chrono::steady_clock::now();
+  vector<uint64_t> layerCounts;
+  if (!externalBreadthFirstSearch(start, options, layerCounts)) return 1;
+  auto seconds = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+
+  uint64_t total = 0;
+  for (size_t d = 0; d < layerCounts.size(); ++d) {
+    cout << d << "\t" << layerCounts[d] << "\n";
+    total += layerCounts[d];
+  }
+  cout << "Reached " << total << " boards of " << W << "x" << H << " in " << layerCounts.size() << " layers in " << seconds
+       << " s" << endl;
+  if (!options.distancePath.empty()) cout << "Wrote the distances to " << options.distancePath << endl;
+  return 0;
+}
+
+int main(int argc, char *argv[]) {
+  int size = 3;
+  string startText;
+  ExternalBfsOptions options;
+  for (int i = 1; i < argc; ++i) {
+    string arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (arg == "--size" && hasValue) size = atoi(argv[++i]);
+    else if (arg == "--start" && hasValue) startText = argv[++i];
+    else if (arg == "--memory" && hasValue && parseByteSize(argv[i + 1], options.memoryBytes)) ++i;
+    else if (arg == "--temp" && hasValue) options.tempDirectory = argv[++i];
+    else if (arg == "--max-depth" && hasValue) options.maxDepth = atoi(argv[++i]);
+    else if (arg == "--distances" && hasValue) options.distancePath = argv[++i];
+    else {
+      cout << "Usage: external_bfs [--size 3|4] [--start \"TILES\"] [--memory BYTES[K|M|G]] [--temp DIR]\n"
+              "                    [--max-depth N] [--distances FILE]\n"
+              "Counts the boards at every distance from the start board (the goal by default), keeping the\n"
+              "layers in sorted files under --temp and at most --memory bytes (default 256M) of buffers.\n";
+      return 1;
+    }
+  }
+  if (size != 3 && size != 4) {
+    cout << "The board size must be 3 or 4, larger boards do not fit a packed key" << endl;
+    return 1;
+  }
+
+  vector<int> startTiles;
+  if (!startText.empty()) {
+    startTiles.resize(size * size);
+    if (!parseBoard(startText, startTiles.data(), size * size)) {
+      cout << "The start board must hold every tile from 0 to " << size * size - 1 << " once" << endl;
+      return 1;
+    }
+  }
+  return size == 3 ? enumerate<3, 3>(startTiles, options) : enumerate<4, 4>(startTiles, options);
+}
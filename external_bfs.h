@@ -0,0 +1,383 @@
+// Breadth-first enumeration of a state space that does not fit in memory:
+// every layer lives in a sorted file of packed boards, and duplicates are
+// removed by merging files rather than by looking boards up in a visited set.
+#pragma once
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <queue>
+#include <string>
+#include <vector>
+
+#include "puzzle.h"
+#include "puzzle_search.h"
+
+using namespace std;
+
+// -------------- Key Files --------------
+// Packed boards (packBoardKey) as raw uint64_t in host byte order, sorted and
+// without duplicates, read and written a whole block at a time.
+
+// Sequential writer of a key file through one block buffer
+class KeyFileWriter {
+ public:
+  KeyFileWriter(size_t blockKeys) : block(blockKeys) {}
+  ~KeyFileWriter() { close(); }
+
+  bool open(const string &path) {
+    close();
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    failed = fd < 0;
+    count = 0;
+    return !failed;
+  }
+
+  void put(uint64_t key) {
+    block[used++] = key;
+    ++count;
+    if (used == block.size()) drain();
+  }
+
+  bool close() {                                                          // false if any write failed
+    if (fd < 0) return !failed;
+    drain();
+    failed |= ::close(fd) != 0;
+    fd = -1;
+    return !failed;
+  }
+
+  uint64_t written() const { return count; }
+
+ private:
+  vector<uint64_t> block;
+  size_t used = 0;
+  int fd = -1;
+  bool failed = false;
+  uint64_t count = 0;
+
+  void drain() {
+    const char *data = reinterpret_cast<const char *>(block.data());
+    size_t left = used * sizeof(uint64_t);
+    while (left > 0 && !failed) {
+      ssize_t done = ::write(fd, data, left);
+      if (done < 0 && errno == EINTR) continue;
+      failed = done <= 0;
+      if (done > 0) data += done, left -= done;
+    }
+    used = 0;
+  }
+};
+
+// Sequential reader of a key file through one block buffer
+class KeyFileReader {
+ public:
+  KeyFileReader(size_t blockKeys) : block(blockKeys) {}
+  KeyFileReader(KeyFileReader &&other)
+      : block(move(other.block)), used(other.used), filled(other.filled), fd(other.fd), failed(other.failed) {
+    other.fd = -1;
+  }
+  ~KeyFileReader() { close(); }
+
+  bool open(const string &path) {
+    close();
+    fd = ::open(path.c_str(), O_RDONLY);
+    used = filled = 0;
+    failed = fd < 0;
+    return !failed && refill();
+  }
+
+  bool done() const { return used == filled; }                            // Also true after a read error, see failed
+  uint64_t peek() const { return block[used]; }
+
+  void advance() {
+    if (++used == filled) refill();
+  }
+
+  bool ok() const { return !failed; }
+
+  void close() {
+    if (fd >= 0) ::close(fd);
+    fd = -1;
+  }
+
+ private:
+  vector<uint64_t> block;
+  size_t used = 0, filled = 0;
+  int fd = -1;
+  bool failed = false;
+
+  bool refill() {                                                         // Reads the next block, whole keys only
+    char *data = reinterpret_cast<char *>(block.data());
+    size_t bytes = 0, capacity = block.size() * sizeof(uint64_t);
+    while (bytes < capacity) {
+      ssize_t got = ::read(fd, data + bytes, capacity - bytes);
+      if (got < 0 && errno == EINTR) continue;
+      if (got <= 0) {
+        failed |= got < 0;
+        break;
+      }
+      bytes += got;
+    }
+    failed |= bytes % sizeof(uint64_t) != 0;
+    used = 0;
+    filled = bytes / sizeof(uint64_t);
+    return !failed;
+  }
+};
+
+// -------------- Distance File Layout --------------
+// An ExternalDistanceHeader, then one block per layer in order of distance:
+// the distance (uint32_t), 4 reserved bytes, the number of boards (uint64_t)
+// and the sorted packed boards of the layer.
+const char externalMagic[4] = {'8', 'P', 'X', 'B'};                       // File signature
+const uint32_t externalVersion = 1;                                       // Bumped whenever the layout changes
+
+struct ExternalDistanceHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t width, height;
+};
+
+struct ExternalLayerHeader {
+  uint32_t distance;
+  uint32_t reserved;
+  uint64_t count;
+};
+
+// -------------- External Breadth-First Search --------------
+struct ExternalBfsOptions {
+  size_t memoryBytes = size_t(256) << 20;                                 // Buffers of the search, all together
+  string tempDirectory = ".";                                             // Where the layer and run files go
+  int maxDepth = -1;                                                      // Last layer to build, -1 for all of them
+  string distancePath;                                                    // Distance file to write, empty for none
+};
+
+/**
+ * @title External Breadth-First Search
+ * @brief Breadth-first search with delayed duplicate detection, after Korf's
+ * external-memory searches. Layer d + 1 is built from the file of layer d
+ * alone: the children of its boards fill a sort buffer that is sorted,
+ * deduplicated and written out as a run file whenever it is full. The runs
+ * are then merged, and the merge drops every board already in layer d or
+ * d - 1, which are the only layers a child can repeat since every move can be
+ * undone. No visited set is kept, so the state space only has to fit on disk,
+ * and every file is read and written sequentially in large blocks. The
+ * memory budget goes to the sort buffer while a layer is expanded, then is
+ * freed and goes to the block buffers of the merge readers, so the search
+ * holds at most the budget (or 8 blocks of 64 KB, if larger) at any time.
+ * Runs beyond what one merge can read at a time are merged in passes first.
+ *
+ * @param start The board the search starts from, usually the goal.
+ * @param options The memory budget, directories and optional distance file.
+ * @param layerCounts Set to the number of boards at every distance.
+ * @return false (after printing the reason) on an I/O error.
+ */
+template <int W, int H>
+bool externalBreadthFirstSearch(const Board<W, H> &start, const ExternalBfsOptions &options, vector<uint64_t> &layerCounts) {
+  const bool writeDistances = !options.distancePath.empty();
+  const size_t blockBytes = min(max(options.memoryBytes / 64, size_t(64) << 10), size_t(4) << 20);
+  const size_t blockKeys = blockBytes / sizeof(uint64_t);
+  const size_t blocks = max(options.memoryBytes / blockBytes, size_t(8));   // The budget in blocks, 8 at least
+  const size_t fixedBlocks = writeDistances ? 2 : 1;                      // The writer's, and the distance file copy's
+  const size_t sortKeys = (blocks - fixedBlocks - 1) * blockKeys;         // Expansion: the sort buffer and the layer reader
+  const size_t fanIn = blocks - fixedBlocks - 2;                          // Merge: the runs and the 2 excluded layers
+  const string prefix = options.tempDirectory + "/external_bfs." + to_string(getpid()) + ".";
+  auto layerPath = [&](int d) { return prefix + "layer." + to_string(d); };
+  int nextRun = 0;
+  auto runPath = [&](int r) { return prefix + "run." + to_string(r); };
+  auto fail = [&](const string &what) {
+    cout << "External BFS: could not " << what << " in " << options.tempDirectory << endl;
+    return false;
+  };
+
+  ofstream distances;
+  if (writeDistances) {
+    distances.open(options.distancePath, ios::binary | ios::trunc);
+    if (!distances) {
+      cout << "External BFS: could not create " << options.distancePath << endl;
+      return false;
+    }
+    ExternalDistanceHeader header;
+    memcpy(header.magic, externalMagic, sizeof(externalMagic));
+    header.version = externalVersion;
+    header.width = W;
+    header.height = H;
+    distances.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  }
+  vector<char> copyBlock(writeDistances ? blockBytes : 0);
+  auto appendLayer = [&](int d, uint64_t count) {                         // Copies a finished layer into the distance file
+    if (!writeDistances) return true;
+    ExternalLayerHeader header = {uint32_t(d), 0, count};
+    distances.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    ifstream layer(layerPath(d), ios::binary);
+    while (layer.read(copyBlock.data(), copyBlock.size()) || layer.gcount() > 0) distances.write(copyBlock.data(), layer.gcount());
+    return bool(distances);
+  };
+
+  // Merges sorted run files into out, dropping duplicates and the keys of
+  // the exclude files, which are sorted as well
+  auto merge = [&](const vector<string> &runs, const vector<string> &excludes, KeyFileWriter &out) {
+    vector<KeyFileReader> readers, excluded;
+    for (const string &path : runs) {
+      readers.emplace_back(blockKeys);
+      if (!readers.back().open(path)) return false;
+    }
+    for (const string &path : excludes) {
+      excluded.emplace_back(blockKeys);
+      if (!excluded.back().open(path)) return false;
+    }
+    auto later = [&](size_t a, size_t b) { return readers[a].peek() > readers[b].peek(); };
+    priority_queue<size_t, vector<size_t>, decltype(later)> heads(later);
+    for (size_t r = 0; r < readers.size(); ++r) {
+      if (!readers[r].done()) heads.push(r);
+    }
+    bool any = false;
+    uint64_t last = 0;
+    while (!heads.empty()) {
+      size_t r = heads.top();
+      heads.pop();
+      uint64_t key = readers[r].peek();
+      readers[r].advance();
+      if (!readers[r].done()) heads.push(r);
+      if (any && key == last) continue;                                   // Same child from another run
+      any = true;
+      last = key;
+      bool seen = false;
+      for (KeyFileReader &old : excluded) {
+        while (!old.done() && old.peek() < key) old.advance();
+        seen |= !old.done() && old.peek() == key;
+      }
+      if (!seen) out.put(key);
+    }
+    for (KeyFileReader &reader : readers) {
+      if (!reader.ok()) return false;
+    }
+    for (KeyFileReader &old : excluded) {
+      if (!old.ok()) return false;
+    }
+    return true;
+  };
+
+  layerCounts.assign(1, 1);
+  KeyFileWriter writer(blockKeys);
+  if (!writer.open(layerPath(0))) return fail("create the layer files");
+  writer.put(packBoardKey(start));
+  if (!writer.close() || !appendLayer(0, 1)) return fail("write the first layer");
+
+  vector<uint64_t> buffer;
+  bool ok = true;
+  for (int d = 0; options.maxDepth < 0 || d < options.maxDepth; ++d) {
+    vector<string> runs;                                                  // Expand layer d into sorted runs
+    buffer.reserve(sortKeys);
+    auto flushRun = [&]() {
+      sort(buffer.begin(), buffer.end());
+      buffer.erase(unique(buffer.begin(), buffer.end()), buffer.end());
+      runs.push_back(runPath(nextRun++));
+      bool written = writer.open(runs.back());
+      for (uint64_t key : buffer) writer.put(key);
+      buffer.clear();
+      return writer.close() && written;
+    };
+    {                                                                     // The reader's block is freed before the merge
+      KeyFileReader layer(blockKeys);
+      if (!layer.open(layerPath(d))) ok = fail("read layer " + to_string(d));
+      for (; ok && !layer.done(); layer.advance()) {
+        uint64_t key = layer.peek();
+        int blank = 0;
+        while ((key >> (4 * blank) & packedCellMask) != 0) ++blank;
+        for (int direction = 0; direction < 4; ++direction) {
+          int next = puzzleTables<W, H>.neighbors[blank][direction];
+          if (next < 0) continue;
+          uint64_t tile = key >> (4 * next) & packedCellMask;             // Slides onto the blank's cell
+          buffer.push_back(key ^ (tile << (4 * next)) ^ (tile << (4 * blank)));
+        }
+        if (buffer.size() + 4 > sortKeys && !flushRun()) ok = fail("write a run file");
+      }
+      if (ok && !layer.ok()) ok = fail("read layer " + to_string(d));
+    }
+    if (ok && !buffer.empty() && !flushRun()) ok = fail("write a run file");
+    vector<uint64_t>().swap(buffer);                                      // Hands the sort buffer's memory to the merge readers
+
+    while (ok && runs.size() > fanIn) {                                   // Too many runs for one merge
+      vector<string> merged;
+      for (size_t first = 0; ok && first < runs.size(); first += fanIn) {
+        vector<string> group(runs.begin() + first, runs.begin() + min(first + fanIn, runs.size()));
+        merged.push_back(runPath(nextRun++));
+        if (!writer.open(merged.back()) || !merge(group, {}, writer) || !writer.close()) ok = fail("merge the run files");
+        for (const string &path : group) remove(path.c_str());
+      }
+      runs = merged;
+    }
+
+    vector<string> excludes = {layerPath(d)};
+    if (d > 0) excludes.push_back(layerPath(d - 1));
+    if (ok && (!writer.open(layerPath(d + 1)) || !merge(runs, excludes, writer) || !writer.close())) {
+      ok = fail("write layer " + to_string(d + 1));
+    }
+    for (const string &path : runs) remove(path.c_str());
+    if (d > 0) remove(layerPath(d - 1).c_str());
+    if (!ok) break;
+    if (writer.written() == 0) {                                          // Every board has been reached
+      remove(layerPath(d + 1).c_str());
+      break;
+    }
+    layerCounts.push_back(writer.written());
+    if (!appendLayer(d + 1, writer.written())) ok = fail("copy layer " + to_string(d + 1) + " to the distance file");
+    if (!ok) break;
+  }
+  for (int d = max(int(layerCounts.size()) - 2, 0); d <= int(layerCounts.size()); ++d) remove(layerPath(d).c_str());
+
+  if (writeDistances && ok) {
+    distances.close();
+    if (!distances) {
+      cout << "External BFS: could not write " << options.distancePath << endl;
+      return false;
+    }
+  }
+  return ok;
+}
+
+/**
+ * @title External Distance Lookup
+ * @brief Distance of a board in a file written by externalBreadthFirstSearch,
+ * found by a binary search of every layer block read straight from the file,
+ * so that lookups need no memory beyond the block headers.
+ *
+ * @return The board's distance from the search's start, -1 if the file does
+ * not hold it or cannot be read.
+ */
+template <int W, int H>
+int externalDistance(const string &path, const Board<W, H> &board) {
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) return -1;
+  ExternalDistanceHeader header;
+  int distance = -1;
+  uint64_t key = packBoardKey(board);
+  bool valid = pread(fd, &header, sizeof(header), 0) == ssize_t(sizeof(header)) &&
+               memcmp(header.magic, externalMagic, sizeof(externalMagic)) == 0 && header.version == externalVersion &&
+               header.width == uint32_t(W) && header.height == uint32_t(H);
+  ExternalLayerHeader layer;
+  for (off_t at = sizeof(header); valid && distance < 0 && pread(fd, &layer, sizeof(layer), at) == ssize_t(sizeof(layer));) {
+    off_t keys = at + sizeof(layer);
+    uint64_t low = 0, high = layer.count;                                 // Binary search of the block
+    while (low < high) {
+      uint64_t middle = (low + high) / 2, found;
+      if (pread(fd, &found, sizeof(found), keys + middle * sizeof(uint64_t)) != ssize_t(sizeof(found))) break;
+      if (found == key) distance = layer.distance;
+      if (found < key) low = middle + 1;
+      else high = middle;
+      if (distance >= 0) break;
+    }
+    at = keys + layer.count * sizeof(uint64_t);
+  }
+  ::close(fd);
+  return distance;
+}
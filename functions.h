@@ -1,4 +1,5 @@
 // All functions needed for my 8-puzzle solver program are defined in this file.
+#pragma once
 
 #include <algorithm>
 #include <functional>
@@ -11,10 +12,28 @@
 #include <vector>
 #include <map>
 
+#include "graph_search.h"
+#include "ida_search.h"
+#include "move_sequence.h"
+#include "open_list.h"
+#include "packed.h"
+#include "puzzle.h"
+#include "rank.h"
+#include "search_context.h"
+#include "search_stats.h"
+#include "simd_heuristics.h"
+
 using namespace std;
 
 // -------------- Global Variables --------------
-const int goal[9] = {1, 2, 3, 8, 0, 4, 7, 6, 5};                          // Goal state of the 8-puzzle, 0 is the empty tile
+constexpr int goal[9] = {1, 2, 3, 8, 0, 4, 7, 6, 5};                      // Goal state of the 8-puzzle, 0 is the empty tile
+const PuzzleTables<3, 3> &tables3x3 = puzzleTables<3, 3>;                 // Compile-time 3x3 neighbor, goal and distance tables
+static_assert([] {
+  for (int i = 0; i < 9; ++i)
+    if (goal[i] != puzzleTables<3, 3>.goal[i]) return false;
+  return true;
+}(), "goal[] must match the generated 3x3 spiral goal");
+const PackedState packedGoal = packBoard(goal);                           // Goal state in its packed form
 
 // ------------- Function declarations -------------
 struct State;
@@ -24,12 +43,30 @@ int cManDist(const State &currentState);                                  // Man
 int cTilesOutOfPlace(const State &currentState);                          // Number of tiles out of place
 bool isSolvable(const State &state);                                      // Solvability Checker
 int cSeqScore(const State &currentState);                                 // Sequence Score Calculator
+int cPatternDb(const State &currentState);                                // Additive Pattern Database Heuristic
 vector<State> getPossibleMoves(const State &state);                       // Possible Moves Generator
-vector<State> depthFirstSearch(const State &initialState);                // Depth-First Search Algorithm
-vector<State> breadthFirstSearch(const State &initialState);              // Breadth-First Search Algorithm
-vector<State> bestFirstSearch(const State &initialState);                 // Best-First Search Algorithm
+int getPackedMoves(PackedState state, PackedState children[4]);           // Packed Possible Moves Generator
+vector<State> depthFirstSearch(const State &initialState,                 // Depth-First Search Algorithm
+                               SearchContext &context = threadSearchContext());
+bool depthFirstSearch(const State &initialState, MoveSequence &moves,
+                      SearchContext &context = threadSearchContext());
+vector<State> breadthFirstSearch(const State &initialState,               // Breadth-First Search Algorithm
+                                 SearchContext &context = threadSearchContext());
+bool breadthFirstSearch(const State &initialState, MoveSequence &moves,
+                        SearchContext &context = threadSearchContext());
+vector<State> bidirectionalSearch(const State &initialState,              // Bidirectional Breadth-First Search Algorithm
+                                  SearchContext &context = threadSearchContext());
+bool bidirectionalSearch(const State &initialState, MoveSequence &moves,
+                         SearchContext &context = threadSearchContext());
+vector<State> bestFirstSearch(const State &initialState, int heuristicType, // Best-First Search Algorithm (A*)
+                              SearchContext &context = threadSearchContext());
+bool bestFirstSearch(const State &initialState, int heuristicType, MoveSequence &moves,
+                     SearchContext &context = threadSearchContext());
+vector<State> idaStarSearch(const State &initialState, int heuristicType);   // Iterative Deepening A* Algorithm
+bool idaStarSearch(const State &initialState, int heuristicType, MoveSequence &moves);
 void printState(const State &state);
-
+PackedState packState(const State &state);                                // Packs a state into its 64-bit encoding
+State unpackState(PackedState packed);                                    // Unpacks a 64-bit encoding into a state
 
 struct State {                                                            // State representation of the 8-puzzle
   int board[9];                                                           // 1D array with 9 elements
@@ -37,35 +74,23 @@ struct State {                                                            // Sta
   int g, h, f;                                                            // g: (depth) cost from start, h: heuristic estimate, f: g + h
 
   
-  State(int tiles[9]) {                                                   // Constructor to initialize the state with a given board configuration
+  State(int tiles[9]) : g(0), h(0), f(0) {                               // Constructor to initialize the state with a given board configuration
     for (int i = 0; i < 9; ++i) {
         board[i] = tiles[i];
+        if (tiles[i] == 0) {
+          blankX = i % 3;
+          blankY = i / 3;
+        }
     }
   }
 
   
-  State() : blankX(0), blankY(0) {                                        // Default constructor
+  State() : blankX(0), blankY(0), g(0), h(0), f(0) {                      // Default constructor
     for (int i = 0; i < 9; ++i) {
         board[i] = 0;
     }
   }
 
-  
-  void calculateHeuristic(int heuristicType) {                            // Function to calculate the heuristic value based on the heuristic type
-    switch (heuristicType) {
-      case 1:                                                             // number of tiles out of place
-        h = cTilesOutOfPlace(*this);
-        break;
-      case 2:                                                             // minimum number of moves to reach the goal state
-        h = cManDist(*this);
-        break;
-      case 3:                                                             // the heuristic H
-        h = cHeuristicH(*this);
-        break;
-    }
-    f = g + h;
-  }
-
   bool operator<(const State &other) const {                              // Less than operator
     for (int i = 0; i < 9; ++i) {                                         // Compare each element of the board
       if (board[i] != other.board[i]) {                                   // If the elements do not match
@@ -99,6 +124,31 @@ int findBlankIndex(const State& state) {
     return -1;                                                            // Error handling if blank not found
   } 
 
+// Packs a state into its 64-bit encoding
+PackedState packState(const State &state) { return packBoard(state.board); }
+
+// Unpacks a 64-bit encoding into a state
+State unpackState(PackedState packed) {
+  State state;
+  unpackBoard(packed, state.board);
+  state.blankX = packed.blankIndex() % 3;
+  state.blankY = packed.blankIndex() / 3;
+  return state;
+}
+
+// Replays the moves from the initial state, giving the path of states
+vector<State> replayMoves(const State &initialState, const MoveSequence &moves) {
+  vector<State> path;
+  path.reserve(moves.size() + 1);
+  PackedState state = packState(initialState);
+  path.push_back(unpackState(state));
+  for (size_t i = 0; i < moves.size(); ++i) {
+    state = applyMove(state, blankMoves[state.blankIndex()][moves[i]]);
+    path.push_back(unpackState(state));
+  }
+  return path;
+}
+
 // Function to calculate heuristic H based off of H = totdist + 3*seq
 int cHeuristicH(const State &state) { return cManDist(state) + 3 * cSeqScore(state); }
 
@@ -123,27 +173,9 @@ bool isGoalState(const State &state) {
 */
 int cManDist(const State &currentState) {
   int totalDistance = 0;                                                  // Initialize the total Manhattan distance
-  unordered_map<int, int> goalPositions;                                  // Mapping from tile values to their goal positions in the 1D array
-  for (int i = 0; i < 9; i++) {
-    int tile = goal[i];
-    if (tile != 0)
-      goalPositions[tile] = i;
-  }
-
   for (int i = 0; i < 9; i++) {                                           // Iterate over the current state
-    int tile = currentState.board[i];                                     // Get the tile value
-    if (tile != 0) {                                                      // Ignore the blank tile 
-      int goalIndex = goalPositions[tile];                                // Get the goal position of the tile
-      int goalRow = goalIndex / 3;                                        // Calculate the row of the goal position
-      int goalCol = goalIndex % 3;                                        // Calculate the column of the goal position
-      int currentRow = i / 3;                                             // Calculate the row of the current position
-      int currentCol = i % 3;                                             // Calculate the column of the current position
-
-      int distance = abs(currentRow - goalRow) + abs(currentCol - goalCol); // Calculate the Manhattan distance
-      totalDistance += distance;                                          // Add the distance to the total
-    }
+    totalDistance += tables3x3.manhattan[currentState.board[i]][i];       // Distance of the tile from its goal position, 0 for the blank
   }
-
   return totalDistance;                                                   // Return the total Manhattan distance
 }
 
@@ -170,17 +202,21 @@ int cTilesOutOfPlace(const State &currentState) {
  * @title Solvability Checker
  * @brief This function checks if a given state of the 8-puzzle game is
  * solvable. It calculates the number of inversions in the state and returns
- * true if the number is even, false otherwise.
+ * true if the number is even, false otherwise. A board holding a number
+ * that is not a tile is never solvable.
  *
  * @param state The state of the 8-puzzle game to check.
  * @return true if the state is solvable, false otherwise.
  */
 bool isSolvable(const State &state) {
+  for (int i = 0; i < 9; ++i) {
+    if (state.board[i] < 0 || state.board[i] > 8) return false;           // Not a tile, and past the end of goalIndex
+  }
   int inversions = 0;
   for (int i = 0; i < 9; ++i) {                                           // Iterate over the tiles
     for (int j = i + 1; j < 9; ++j) {                                     // Iterate over the tiles after the current tile
-      int pos_i = find(goal, goal + 9, state.board[i]) - goal;            // Find the position of the current tile in the goal state
-      int pos_j = find(goal, goal + 9, state.board[j]) - goal;            // Find the position of the next tile in the goal state
+      int pos_i = tables3x3.goalIndex[state.board[i]];                    // Find the position of the current tile in the goal state
+      int pos_j = tables3x3.goalIndex[state.board[j]];                    // Find the position of the next tile in the goal state
       if (state.board[i] != 0 && state.board[j] != 0 && pos_i > pos_j) {  // Check if the current tile is after the next tile in the goal state
         ++inversions;
       }
@@ -201,17 +237,17 @@ bool isSolvable(const State &state) {
  */
 int cSeqScore(const State &currentState) {
   int score = 0;
-  const int centerIndex = 4;                                              // Index of the center tile
+  const int centerIndex = tables3x3.blankGoal;                            // Index of the center tile
 
   if (currentState.board[centerIndex] != 0)                               // Check if the center tile is not the blank tile
     score += 1;
 
-  int clockwiseOrder[] = {0, 1, 2, 5, 8, 7, 6, 3};                        // Clockwise indices
+  const int *clockwiseOrder = tables3x3.ring;                             // Clockwise indices
   for (int i = 0; i < 8; i++) {                                           // Start at index 0 to include center
     int tile = currentState.board[clockwiseOrder[i]];
     if (tile == 0) continue;                                              // Skip the blank tile
 
-    int goalSuccessor = (tile == 8) ? 1 : tile + 1;                       // Get the goal successor of the tile
+    int goalSuccessor = tables3x3.successor[tile];                        // Get the goal successor of the tile
     int clockwiseNeighborIndex = (i + 1) % 8;                             // Wrap around for the next tile
     int clockwiseNeighbor = currentState.board[clockwiseOrder[clockwiseNeighborIndex]]; // Get the clockwise neighbor
     if (clockwiseNeighbor != goalSuccessor) {                             // Check if the neighbor is not the goal successor
@@ -221,6 +257,20 @@ int cSeqScore(const State &currentState) {
   return score;
 }
 
+/**
+ * @title Pattern Database Heuristic
+ * @brief This function sums the exact costs of the disjoint tile groups of
+ * the additive pattern database (tiles 1-4 and 5-8 by default, or the file
+ * named by patternDatabasePath). It never overestimates and is at least as
+ * large as the Manhattan distance.
+ *
+ * @param currentState The current state of the 8-puzzle game.
+ * @return The pattern database estimate.
+ */
+int cPatternDb(const State &currentState) {
+  return defaultPatternDatabase<3, 3>().evaluate(makeBoard<3, 3>(currentState.board));
+}
+
 /**
  * @title Possible Moves Generator
  * @brief This function generates the possible moves (children) from a given
@@ -235,18 +285,18 @@ int cSeqScore(const State &currentState) {
 vector<State> getPossibleMoves(const State &state) {
   int blankIndex = findBlankIndex(state);                                 // Find the index of the blank tile (0)
 
-  vector<int> moves = {-3, 3, -1, 1};                                     // Up, Down, Left, Right
+  const int8_t *moves = tables3x3.neighbors[blankIndex];                  // Up, Down, Left, Right, -1 when off the board
   vector<State> possibleMoves;                                            // Vector to store the possible moves
 
-  for (int move : moves) {                                                // Iterate over the moves
-    int newIndex = blankIndex + move;                                     // Calculate the new index
-
-    if (newIndex >= 0 && newIndex < 9) {                                  // Check if within bounds
-      if ((move == -1 && blankIndex % 3 == 0) || (move == 1 && blankIndex % 3 == 2)) // Check if move is left or right, and if so, ensure it doesn't wrap around
-        continue;
+  for (int i = 0; i < 4; ++i) {                                           // Iterate over the moves
+    int newIndex = moves[i];                                              // The new index of the blank
 
+    if (newIndex >= 0) {                                                  // Check if within bounds
       State newState = state;                                             // Create a new state
       swap(newState.board[newIndex], newState.board[blankIndex]);         // Swap directly
+      newState.blankX = newIndex % 3;                                     // Record where the blank moved to
+      newState.blankY = newIndex / 3;
+      newState.g = state.g + 1;                                           // One move deeper than the parent
 
       possibleMoves.push_back(newState);                                  // Add the new state to the possible moves
     }
@@ -258,160 +308,254 @@ vector<State> getPossibleMoves(const State &state) {
 /**
  * @title Depth-First Search Algorithm
  * @brief This function performs a depth-first search from the initial state
- * to the goal state of the 8-puzzle game. It uses a stack to keep track of
- * the frontier and a set to keep track of visited states.
+ * to the goal state of the 8-puzzle game. It is graphSearch with a stack as
+ * the frontier and a visited bitset with one parent byte per state.
  *
  * @param initialState The initial state of the 8-puzzle game.
- * @return A pair consisting of the path from the initial state to the goal
- * state and the number of nodes expanded.
+ * @param moves Set to the moves from the initial state to the goal state.
+ * @param context Storage reused between searches, reset on entry.
+ * @return true if the goal state was reached.
  */
-vector<State> depthFirstSearch(const State &initialState) {
-  stack<State> frontier;                                                  // Stack to keep track of the frontier
-  set<State> visited;                                                     // Set to keep track of visited states
-  map<State, State> cameFrom;                                             // Map to store the parent state
-  State currentState;                                                     // Current state
-
-  frontier.push(initialState);                                            // Add the initial state to the frontier
-
-  while (!frontier.empty()) {
-    currentState = frontier.top();                                        // Get the current state from the frontier
-    frontier.pop();                                                       // Pop the current state from the frontier
-
-    if (isGoalState(currentState)) {                                      // Check if the current state is the goal state
-      vector<State> path;
-      for (State state = currentState; state != initialState; state = cameFrom[state]) {
-        path.push_back(state);                                            // Add the state to the path
-      }
-      path.push_back(initialState);                                       // Add the initial state
-      reverse(path.begin(), path.end());                                  // reverse the path to start from the initial state
-      return path;                                                        // Goal found!
-    }
-
-    if (visited.find(currentState) == visited.end()) {
-      visited.insert(currentState);                                       // Mark the state as visited
-
-      vector<State> children = getPossibleMoves(currentState);
-
-      for (auto child : children) {
-        if (visited.find(child) == visited.end()) {                       // Check if the child is not visited
-          frontier.push(child);                                           // Add the child to the frontier
-          cameFrom[child] = currentState;                                 // Record the parent state
-        }
-      }
-    }
-  }
+bool depthFirstSearch(const State &initialState, MoveSequence &moves, SearchContext &context) {
+  context.reset();
+  StackFrontier frontier(context.frontier);
+  ClosedRankSet visited(context.visited, context.parents);
+  return graphSearch<PackedEncoding>(packState(initialState), frontier, visited, ZeroHeuristic(), moves);
+}
 
-  return vector<State>();                                                 // No solution found
+// Depth-first search, path of states from the initial state to the goal
+vector<State> depthFirstSearch(const State &initialState, SearchContext &context) {
+  MoveSequence moves;
+  if (!depthFirstSearch(initialState, moves, context)) return vector<State>();
+  return replayMoves(initialState, moves);
 }
 
 /**
  * @title Breadth-First Search Algorithm
  * @brief This function performs a breadth-first search from the initial state
- * to the goal state of the 8-puzzle game. It uses a queue to keep track of
- * the frontier and a set to keep track of visited states.
+ * to the goal state of the 8-puzzle game. It is graphSearch with a queue as
+ * the frontier and a visited bitset with one parent byte per state.
  *
  * @param initialState The initial state of the 8-puzzle game.
- * @return A pair consisting of the path from the initial state to the goal
- * state and the number of nodes expanded.
+ * @param moves Set to the moves from the initial state to the goal state.
+ * @param context Storage reused between searches, reset on entry.
+ * @return true if the goal state was reached.
  */
-vector<State> breadthFirstSearch(const State &initialState) {
-  queue<State> frontier;                                                  // Queue to keep track of the frontier
-  set<State> visited;                                                     // Set to keep track of visited states
-  map<State, State> cameFrom;                                             // Map to store the parent state
-  State currentState;                                                     // Current state
-
-  frontier.push(initialState);                                            // Add the initial state to the frontier
-
-  while (!frontier.empty()) {
-    currentState = frontier.front();                                      // Get the current state from the frontier
-    frontier.pop();                                                       // Remove the current state from the frontier
-
-    if (isGoalState(currentState)) {
-      vector<State> path;
-      for (State state = currentState; state != initialState; state = cameFrom[state]) {
-        path.push_back(state);                                            // Add the state to the path
-      }
-      path.push_back(initialState);                                       // Add the initial state
-      reverse(path.begin(), path.end());                                  // reverse the path to start from the initial state
-      return path;                                                        // Goal found!
-    }
-
-    if (visited.find(currentState) == visited.end()) {
-      visited.insert(currentState);                                       // Mark the state as visited
+bool breadthFirstSearch(const State &initialState, MoveSequence &moves, SearchContext &context) {
+  context.reset();
+  QueueFrontier frontier(context.frontier);
+  ClosedRankSet visited(context.visited, context.parents);
+  return graphSearch<PackedEncoding>(packState(initialState), frontier, visited, ZeroHeuristic(), moves);
+}
 
-      vector<State> children = getPossibleMoves(currentState);
+// Breadth-first search, path of states from the initial state to the goal
+vector<State> breadthFirstSearch(const State &initialState, SearchContext &context) {
+  MoveSequence moves;
+  if (!breadthFirstSearch(initialState, moves, context)) return vector<State>();
+  return replayMoves(initialState, moves);
+}
 
-      for (auto child : children) {
-        if (visited.find(child) == visited.end()) {                       // Check if the child is not visited
-          frontier.push(child);                                           // Add the child to the frontier
-          cameFrom[child] = currentState;                                 // Record the parent state
+const int noMeeting = 1 << 30;                                            // Meeting cost before the two searches meet
+
+// Expands one whole layer of a bidirectional search, returns the cheapest
+// meeting state found with the other side (0 bits if none) and its cost
+PackedState expandLayer(vector<PackedState> &layer, vector<PackedState> &next, RankBitset &visited, RankParents &parents,
+                        const RankBitset &otherVisited, const vector<uint8_t> &otherDepth, int depth, int &meetingCost) {
+  next.clear();
+  PackedState children[4];
+  PackedState meeting;
+  for (PackedState state : layer) {
+    countStat(searchStats.nodesExpanded);
+    chargeTime(searchStats.bookkeepingSeconds);
+    int childCount = getPackedMoves(state, children);
+    countStat(searchStats.nodesGenerated, childCount);
+    chargeTime(searchStats.expansionSeconds);
+    for (int i = 0; i < childCount; ++i) {
+      uint32_t childRank = rankPacked(children[i]);
+      if (!visited.insert(childRank)) {                                   // Already reached from this side
+        countStat(searchStats.duplicateHits);
+        continue;
+      }
+      parents.set(childRank, state.blankIndex());
+      next.push_back(children[i]);
+      if (otherVisited.test(childRank)) {                                 // The two searches meet here
+        int cost = depth + 1 + otherDepth[childRank];
+        if (cost < meetingCost) {
+          meetingCost = cost;
+          meeting = children[i];
         }
       }
     }
   }
-
-  return vector<State>();                                                 // No solution found
+  layer.swap(next);
+  return meeting;
 }
 
 /**
- * @title Best-First Search Algorithm
- * @brief This function performs a best-first search from the initial state to
- * the goal state of the 8-puzzle game. It uses a priority queue to keep track
- * of the frontier, with states ordered by their heuristic value, and a set to
- * keep track of visited states.
+ * @title Bidirectional Breadth-First Search Algorithm
+ * @brief This function runs two breadth-first searches at once, one forward
+ * from the initial state and one backward from the goal state, always
+ * expanding a whole layer of the side with the smaller frontier. It stops at
+ * the end of the first layer in which the two sides meet, and stitches the
+ * forward half and the backward half together at the cheapest meeting state.
+ * Each side only has to reach about half the solution depth, so far fewer
+ * states are explored than in breadthFirstSearch.
  *
- * @details Function uses cManDist, cSeqScore, and cHeuristicH functions to
- * calculate the heuristic values.
- * @see cManDist, cSeqScore, cHeuristicH
  * @param initialState The initial state of the 8-puzzle game.
- * @return A pair consisting of the path from the initial state to the goal
- * state and the number of nodes expanded.
+ * @param moves Set to the shortest moves from the initial state to the goal state.
+ * @param context Storage reused between searches, reset on entry.
+ * @return true if the state is solvable.
  */
-vector<State> bestFirstSearch(const State &initialState, int heuristicType) {
-  auto compare = [heuristicType](pair<State, vector<State>> a, pair<State, vector<State>> b) {  // Lambda function to compare states based on heuristic value
-    switch (heuristicType) {                                                                    // Switch statement to determine the heuristic type
-      case 1:                                                                                   // depth in the search space + number of tiles out of place
-        return a.first.g + cTilesOutOfPlace(a.first) > b.first.g + cTilesOutOfPlace(b.first);   // Compare the heuristic values
-      case 2:                                                                                   // depth in the search space + minimum number of moves to reach the goal state
-        return a.first.g + cManDist(a.first) > b.first.g + cManDist(b.first);                   // Compare the heuristic values
-      case 3:                                                                                   // depth in the search space + the heuristic H
-        return a.first.g + cHeuristicH(a.first) > b.first.g + cHeuristicH(b.first);             // Compare the heuristic values
+bool bidirectionalSearch(const State &initialState, MoveSequence &moves, SearchContext &context) {
+  moves.clear();
+  startStats();
+  if (!isSolvable(initialState)) return false;                            // The two sides would never meet
+
+  PackedState initial = packState(initialState);
+  if (initial == packedGoal) return true;
+
+  context.reset();
+  context.visited.clear();
+  context.backwardVisited.clear();
+  context.useDepths();
+  RankBitset &forwardVisited = context.visited, &backwardVisited = context.backwardVisited;
+  RankParents &forwardParents = context.parents, &backwardParents = context.backwardParents;
+  vector<uint8_t> &forwardDepth = context.forwardDepth, &backwardDepth = context.backwardDepth; // Layer of every reached state
+  vector<PackedState> &forwardLayer = context.frontier, &backwardLayer = context.backwardFrontier;
+  forwardLayer.push_back(initial);
+  backwardLayer.push_back(packedGoal);
+  int forwardLevel = 0, backwardLevel = 0;
+  forwardVisited.insert(rankPacked(initial));
+  backwardVisited.insert(rankPacked(packedGoal));
+  forwardDepth[rankPacked(initial)] = 0;                                  // Left over from earlier searches otherwise
+  backwardDepth[rankPacked(packedGoal)] = 0;
+
+  int meetingCost = noMeeting;
+  PackedState meeting;
+  while (meetingCost == noMeeting && !forwardLayer.empty() && !backwardLayer.empty()) {
+    if (forwardLayer.size() <= backwardLayer.size()) {                    // Grow the cheaper side
+      meeting = expandLayer(forwardLayer, context.nextLayer, forwardVisited, forwardParents, backwardVisited, backwardDepth,
+                            forwardLevel, meetingCost);
+      ++forwardLevel;
+      for (PackedState state : forwardLayer) forwardDepth[rankPacked(state)] = forwardLevel;
+    } else {
+      meeting = expandLayer(backwardLayer, context.nextLayer, backwardVisited, backwardParents, forwardVisited, forwardDepth,
+                            backwardLevel, meetingCost);
+      ++backwardLevel;
+      for (PackedState state : backwardLayer) backwardDepth[rankPacked(state)] = backwardLevel;
     }
-    return false;                                                                               // Default return value to avoid compiler warning
-  };
-  priority_queue<pair<State, vector<State>>, vector<pair<State, vector<State>>>, decltype(compare)> frontier(compare);
-
-  set<State> visited; 
-  vector<State> path; 
-  State currentState;
-
-  frontier.push({initialState, {}});
+    peakStat(searchStats.peakFrontier, forwardLayer.size() + backwardLayer.size());
+    peakStat(searchStats.bytesAllocated, 2 * (forwardVisited.bytes() + forwardParents.bytes() + stateCount) +
+                                             (forwardLayer.capacity() + backwardLayer.capacity()) * sizeof(PackedState));
+  }
+  chargeTime(searchStats.bookkeepingSeconds);
+  peakStat(searchStats.peakVisited, 2 + searchStats.nodesGenerated - searchStats.duplicateHits);
+  if (meetingCost == noMeeting) return false;                            // No solution found
+
+  moves = reconstructMoves(forwardParents, initial, meeting);             // Start ... meeting state
+  for (PackedState state = meeting; state != packedGoal;) {               // Meeting state ... goal
+    int blank = state.blankIndex();
+    state = applyMove(state, backwardParents.get(rankPacked(state)));
+    moves.push(moveDirection<3, 3>(blank, state.blankIndex()));
+  }
+  return true;
+}
 
-  while (!frontier.empty()) {                                             // While the frontier is not empty
-    tie(currentState, path) = frontier.top();                             // Get the current state and path from the frontier
-    frontier.pop();                                                       // Remove the current state from the frontier
+// Bidirectional search, shortest path of states from the initial state to the goal
+vector<State> bidirectionalSearch(const State &initialState, SearchContext &context) {
+  MoveSequence moves;
+  if (!bidirectionalSearch(initialState, moves, context)) return vector<State>();
+  return replayMoves(initialState, moves);
+}
 
-    if (isGoalState(currentState)) {
-      path.push_back(currentState);                                       // Add the current state to the path
-      return path;                                                        // Goal found! Return the path
-    }
+/**
+ * @title Best-First Search Algorithm (A*)
+ * @brief This function performs an A* search from the initial state to the
+ * goal state of the 8-puzzle game. It is graphSearch with an f-ordered open
+ * list (ties towards higher g), BucketQueue or HeapQueue from open_list.h, and
+ * a node pool that reopens a closed state when a cheaper path to it turns up,
+ * so the returned path is optimal whenever the heuristic is admissible
+ * (heuristics 1, 2 and 4). The heuristic is picked once per search, and the
+ * children of an expansion are scored together by the batch kernels of
+ * simd_heuristics.h, bit-identical to the scalar heuristics.
+ *
+ * @details Function uses the same heuristics as cTilesOutOfPlace, cManDist,
+ * cHeuristicH and cPatternDb.
+ * @see cTilesOutOfPlace, cManDist, cHeuristicH, cPatternDb
+ * @param initialState The initial state of the 8-puzzle game.
+ * @param heuristicType The heuristic to use, as numbered in the menu.
+ * @param context Storage reused between searches, reset on entry.
+ * @param open The open list, emptied on entry.
+ * @param moves Set to the moves from the initial state to the goal state.
+ * @return true if the goal state was reached.
+ */
+template <typename OpenList>
+bool bestFirstSearchWith(const State &initialState, int heuristicType, SearchContext &context, OpenList &open,
+                         MoveSequence &moves) {
+  context.reset();
+  open.clear();
+  OrderedFrontier<OpenList> frontier(open);
+  NodePool<PackedEncoding> visited(context.nodes, context.bestNode);
+  return withHeuristic(heuristicType, [&](const auto &heuristic) {
+    return graphSearch<PackedEncoding>(packState(initialState), frontier, visited, heuristic, moves);
+  });
+}
 
-    if (visited.find(currentState) == visited.end()) {                    // Check if the state is not visited
-      visited.insert(currentState);                                       // Mark the state as visited
+// Best-first search with the bucket open list, f values being small integers
+bool bestFirstSearch(const State &initialState, int heuristicType, MoveSequence &moves, SearchContext &context) {
+  return bestFirstSearchWith(initialState, heuristicType, context, context.open, moves);
+}
 
-      vector<State> children = getPossibleMoves(currentState);            // Get the possible moves from the current state
+// Best-first search, path of states from the initial state to the goal
+vector<State> bestFirstSearch(const State &initialState, int heuristicType, SearchContext &context) {
+  MoveSequence moves;
+  if (!bestFirstSearch(initialState, heuristicType, moves, context)) return vector<State>();
+  return replayMoves(initialState, moves);
+}
 
-      for (auto child : children) {                                       // Iterate over the children
-        if (visited.find(child) == visited.end()) {                       // Check if the child is not visited
-          vector<State> newPath = path;                                   // Create a new path
-          newPath.push_back(child);                                       // Add the child to the path
-          frontier.push({child, newPath});                                // Add the child and path to the frontier
-        }
-      }
-    }
+// Replays the blank index after each move from the initial state, giving
+// the path of states the generic engines found
+vector<State> replayBlankPath(const State &initialState, const vector<int> &blankPath) {
+  vector<State> path;
+  PackedState state = packState(initialState);
+  path.push_back(unpackState(state));
+  for (int blank : blankPath) {
+    state = applyMove(state, blank);
+    path.push_back(unpackState(state));
   }
+  return path;
+}
+
+/**
+ * @title Iterative Deepening A* Algorithm
+ * @brief This function performs iterative deepening A* from the initial
+ * state to the goal state of the 8-puzzle game. Each iteration is a
+ * depth-first search bounded by f = g + h, the next bound being the smallest
+ * f that exceeded the current one. Moves are made and undone on a single
+ * board, the move that would undo the previous one is skipped, and Manhattan
+ * distance and misplaced tiles are updated from the moved tile alone, so the
+ * search performs no heap allocation and uses O(depth) memory. The engine is
+ * IdaSearch from ida_search.h, the same one that solves larger boards.
+ *
+ * @details Function uses the same heuristics as cTilesOutOfPlace, cManDist,
+ * cHeuristicH and cPatternDb.
+ * @param initialState The initial state of the 8-puzzle game.
+ * @param heuristicType The heuristic to use, as numbered in the menu.
+ * @return The path from the initial state to the goal state, optimal with the
+ * admissible heuristics 1, 2 and 4.
+ */
+vector<State> idaStarSearch(const State &initialState, int heuristicType) {
+  vector<int> blankPath;
+  if (!idaStar(makeBoard<3, 3>(initialState.board), heuristicType, blankPath)) return vector<State>();
+  return replayBlankPath(initialState, blankPath);
+}
 
-  return vector<State>();                                                 // No solution found  
+// Iterative deepening A*, moves from the initial state to the goal
+bool idaStarSearch(const State &initialState, int heuristicType, MoveSequence &moves) {
+  vector<int> blankPath;
+  bool found = idaStar(makeBoard<3, 3>(initialState.board), heuristicType, blankPath);
+  moves = MoveSequence::fromBlankPath<3, 3>(findBlankIndex(initialState), blankPath);
+  return found;
 }
 
 // Function to print the state in human readable format, encasing the board in a
@@ -431,13 +575,15 @@ void printState(const State &state) {
 // Function to print rows of states in human readable format
 void printStates(const vector<State> &states) {
   vector<string> buffers(5, "");                                          // 5 lines for each board
+  for (string &line : buffers) line.reserve(states.size() * 11);          // 11 characters per board, no regrowth
 
   for (const auto &state : states) {
     buffers[0] += "---------  ";                                          // Top border
     for (int i = 0; i < 9; i += 3) {                                      // Iterate over the rows
       buffers[i / 3 + 1] += "| ";                                         // Left border
       for (int j = i; j < i + 3; j++) {                                   // Iterate over the columns
-        buffers[i / 3 + 1] += to_string(state.board[j]) + " ";            // Print the value of the tile
+        buffers[i / 3 + 1] += char('0' + state.board[j]);                 // Tiles are single digits
+        buffers[i / 3 + 1] += ' ';
       }
       buffers[i / 3 + 1] += "|  ";                                        // Right border
     }
@@ -0,0 +1,149 @@
+// Writes a seeded corpus of solvable boards with a chosen mix of optimal
+// depths, as batch-mode input lines or as binary records.
+// Usage: generate_workload [--count N] [--seed S] [--depths natural|D|D-E[:W],...]
+//                          [--distances FILE] [--format text|binary] [--with-depth]
+//                          [--output FILE]
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+#include "workload.h"
+
+struct WorkloadOptions {
+  uint64_t count = 1000;
+  uint64_t seed = 1;
+  string depths = "natural";
+  string distancePath;                                                    // external_bfs distance file, empty for the 8-puzzle
+  bool binary = false;
+  bool withDepth = false;                                                 // Text lines end with a tab and the depth
+  string outputPath = "-";
+};
+
+void printWorkloadUsage() {
+  cout << "Usage: generate_workload [--count N] [--seed S] [--depths natural|D|D-E[:W],...]\n"
+          "                         [--distances FILE] [--format text|binary] [--with-depth] [--output FILE]\n"
+          "Draws solvable boards whose optimal depth follows --depths: natural draws uniformly over all boards,\n"
+          "\"28\" only at depth 28, \"20-24,30:4\" evenly over 20 to 24 with depth 30 four times as likely.\n"
+          "8-puzzle boards by default, or the boards of a distance file written by external_bfs. Text lines\n"
+          "are batch-mode input.\n";
+}
+
+// Parses the command line, false (after printing why) on bad arguments
+bool parseWorkloadOptions(int argc, char *argv[], WorkloadOptions &options) {
+  for (int i = 1; i < argc; ++i) {
+    string flag = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (flag == "--count" && hasValue) {
+      options.count = strtoull(argv[++i], nullptr, 10);
+    } else if (flag == "--seed" && hasValue) {
+      options.seed = strtoull(argv[++i], nullptr, 10);
+    } else if (flag == "--depths" && hasValue) {
+      options.depths = argv[++i];
+    } else if (flag == "--distances" && hasValue) {
+      options.distancePath = argv[++i];
+    } else if (flag == "--format" && hasValue) {
+      string format = argv[++i];
+      if (format != "text" && format != "binary") {
+        cout << "The format must be text or binary" << endl;
+        return false;
+      }
+      options.binary = format == "binary";
+    } else if (flag == "--with-depth") {
+      options.withDepth = true;
+    } else if (flag == "--output" && hasValue) {
+      options.outputPath = argv[++i];
+    } else {
+      cout << "Unknown option " << flag << endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+// Draws the boards into out through a 64 KB buffer
+void writeWorkload(const WorkloadOptions &options, const DepthIndex &index, WorkloadGenerator &generator, ostream &out) {
+  const size_t capacity = 1 << 16, recordBytes = 64;                      // A text line takes at most 16 * 3 + 4 bytes
+  const int cells = index.width * index.height;
+  vector<char> buffer(capacity);
+  size_t used = 0;
+  if (options.binary) {
+    WorkloadFileHeader header;
+    memcpy(header.magic, workloadMagic, sizeof(workloadMagic));
+    header.version = workloadVersion;
+    header.width = index.width;
+    header.height = index.height;
+    header.count = options.count;
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  }
+
+  for (uint64_t n = 0; n < options.count; ++n) {
+    if (used + recordBytes > capacity) {
+      out.write(buffer.data(), used);
+      used = 0;
+    }
+    int depth;
+    uint64_t key = generator.next(depth);
+    char *at = buffer.data() + used;
+    if (options.binary) {
+      memcpy(at, &key, sizeof(key));
+      at[sizeof(key)] = char(depth);
+      used += sizeof(key) + 1;
+      continue;
+    }
+    for (int i = 0; i < cells; ++i) {
+      int tile = (key >> (4 * i)) & packedCellMask;
+      if (tile >= 10) *at++ = '1';
+      *at++ = char('0' + tile % 10);
+      *at++ = i + 1 < cells ? ' ' : '\n';
+    }
+    if (options.withDepth) {
+      at[-1] = '\t';
+      if (depth >= 10) *at++ = char('0' + depth / 10 % 10);              // Depths stay below 100 on these puzzles
+      *at++ = char('0' + depth % 10);
+      *at++ = '\n';
+    }
+    used = at - buffer.data();
+  }
+  out.write(buffer.data(), used);
+  out.flush();
+}
+
+int main(int argc, char *argv[]) {
+  WorkloadOptions options;
+  if (!parseWorkloadOptions(argc, argv, options)) {
+    printWorkloadUsage();
+    return 1;
+  }
+
+  DepthIndex index;
+  if (options.distancePath.empty()) {
+    index.buildEightPuzzle();
+  } else if (!index.open(options.distancePath)) {
+    cout << "Could not read the distance file " << options.distancePath << ", write one from the goal with external_bfs --distances" << endl;
+    return 1;
+  }
+  vector<uint64_t> weights;
+  if (!parseDepthMix(options.depths, index, weights)) return 1;
+  WorkloadGenerator generator(index, weights, options.seed);
+
+  auto start = chrono::steady_clock::now();
+  ofstream file;
+  if (options.outputPath != "-") {
+    file.open(options.outputPath, ios::binary | ios::trunc);
+    if (!file) {
+      cout << "Could not create " << options.outputPath << endl;
+      return 1;
+    }
+  }
+  ostream &out = options.outputPath == "-" ? cout : file;
+  writeWorkload(options, index, generator, out);
+  if (!out) {
+    cerr << "Could not write the workload" << endl;
+    return 1;
+  }
+  double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+  cerr << "Wrote " << options.count << " boards in " << seconds << " s" << endl;
+  return 0;
+}
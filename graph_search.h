@@ -0,0 +1,424 @@
+// One search loop for the puzzle engines, specialized at compile time by
+// policies: the state encoding, the order of the frontier, how reached
+// states are recorded and the heuristic. Depth-first, breadth-first and
+// best-first search are instantiations of graphSearch over packed 8-puzzle
+// boards (see functions.h), and the memory-bounded A* of puzzle_search.h is
+// one over W x H board keys.
+#pragma once
+
+#include <vector>
+
+#include "move_sequence.h"
+#include "open_list.h"
+#include "packed.h"
+#include "rank.h"
+#include "search_context.h"
+#include "search_stats.h"
+#include "simd_heuristics.h"
+
+using namespace std;
+
+// -------------- State Encodings --------------
+// How a search stores its states: the goal, the children of a state in the
+// Up, Down, Left, Right order of the puzzle tables, the node the node pool
+// keeps for a state, the key of a state in the hash maps, and how the
+// children of a node are scored by the encoding's heuristic functors.
+
+// Packed 8-puzzle boards, scored by the batch functors of simd_heuristics.h
+struct PackedEncoding {
+  using State = PackedState;
+  using Node = SearchNode;
+  static const int width = 3, height = 3;
+
+  static PackedState goal() { return packBoard(puzzleTables<3, 3>.goal); }
+  static int blank(PackedState state) { return state.blankIndex(); }
+  static PackedState hashKey(PackedState state) { return state; }
+
+  static int children(PackedState state, PackedState out[4]) {
+    const int8_t *moves = blankMoves[state.blankIndex()];
+    int count = 0;
+    for (int i = 0; i < 4; ++i) {
+      if (moves[i] >= 0) out[count++] = applyMove(state, moves[i]);
+    }
+    return count;
+  }
+
+  static SearchNode node(PackedState state, int parent, int g, int h) { return {state, parent, g, h, g + h}; }
+  static PackedState state(const SearchNode &node) { return node.state; }
+
+  template <typename Heuristic>
+  static int score(const Heuristic &heuristic, PackedState state) {
+    int h;
+    heuristic(&state, 1, &h);
+    return h;
+  }
+
+  template <typename Heuristic>
+  static void scoreChildren(const Heuristic &heuristic, const SearchNode &, const PackedState *children, int count,
+                            int *out) {
+    heuristic(children, count, out);                                      // Score all new children in one kernel call
+  }
+};
+
+// Board of a W x H search: its packBoardKey and the index of its blank
+struct BoardKey {
+  uint64_t key;
+  int blank;
+
+  bool operator==(const BoardKey &other) const { return key == other.key; } // The key decides the blank
+  bool operator!=(const BoardKey &other) const { return key != other.key; }
+};
+
+// Keys of W x H boards of up to 16 cells, scored by the functors of
+// ida_search.h, incrementally from the parent's h when they allow it
+template <int W, int H>
+struct BoardEncoding {
+  using State = BoardKey;
+  using Node = GenericNode;
+  static const int width = W, height = H;
+
+  static BoardKey goal() {
+    Board<W, H> board = goalBoard<W, H>();
+    return {packBoardKey(board), board.blank};
+  }
+  static BoardKey encode(const Board<W, H> &board) { return {packBoardKey(board), board.blank}; }
+  static int blank(const BoardKey &state) { return state.blank; }
+  static PackedState hashKey(const BoardKey &state) { return PackedState(state.key); }
+
+  static int children(const BoardKey &state, BoardKey out[4]) {
+    const int8_t *moves = puzzleTables<W, H>.neighbors[state.blank];
+    int count = 0;
+    for (int i = 0; i < 4; ++i) {
+      if (moves[i] >= 0) out[count++] = {applyKeyMove(state.key, state.blank, moves[i]), moves[i]};
+    }
+    return count;
+  }
+
+  static GenericNode node(const BoardKey &state, int parent, int g, int h) { return {state.key, state.blank, parent, g, h}; }
+  static BoardKey state(const GenericNode &node) { return {node.key, node.blank}; }
+
+  template <typename Heuristic>
+  static int score(const Heuristic &heuristic, const BoardKey &state) {
+    return heuristic(unpackBoardKey<W, H>(state.key));
+  }
+
+  template <typename Heuristic>
+  static void scoreChildren(const Heuristic &heuristic, const GenericNode &parent, const BoardKey *children, int count,
+                            int *out) {
+    for (int i = 0; i < count; ++i) {                                     // The tile moved from the child's blank to the parent's
+      int tile = (children[i].key >> (4 * parent.blank)) & packedCellMask;
+      out[i] = heuristic.afterMove(parent.h, tile, children[i].blank, parent.blank, children[i].key);
+    }
+  }
+};
+
+// Packed counterpart of getPossibleMoves, writes up to 4 children in the same
+// Up, Down, Left, Right order and returns how many were generated
+int getPackedMoves(PackedState state, PackedState children[4]) { return PackedEncoding::children(state, children); }
+
+// -------------- Path Reconstruction --------------
+// Rebuilds the moves by sliding the blank back to each recorded parent blank index
+MoveSequence reconstructMoves(const RankParents &parents, PackedState initial, PackedState goalState) {
+  MoveSequence moves;
+  for (PackedState state = goalState; state != initial;) {
+    int blank = state.blankIndex();
+    state = applyMove(state, parents.get(rankPacked(state)));             // Step back to the parent
+    moves.push(moveDirection<3, 3>(state.blankIndex(), blank));
+  }
+  moves.reverse();                                                        // reverse the moves to start from the initial state
+  return moves;
+}
+
+// Rebuilds the moves by walking the parent indices of the node pool
+template <typename Encoding>
+MoveSequence reconstructMoves(const vector<typename Encoding::Node> &nodes, int goalNode) {
+  MoveSequence moves;
+  for (int index = goalNode; nodes[index].parent >= 0; index = nodes[index].parent) {
+    int from = Encoding::blank(Encoding::state(nodes[nodes[index].parent]));
+    moves.push(moveDirection<Encoding::width, Encoding::height>(from, Encoding::blank(Encoding::state(nodes[index]))));
+  }
+  moves.reverse();                                                        // reverse the moves to start from the initial state
+  return moves;
+}
+
+// Records the memory held by a rank-indexed search once it is over
+void finishRankSearch(size_t frontierBytes, const RankBitset &visited, const RankParents &parents) {
+  chargeTime(searchStats.bookkeepingSeconds);
+  peakStat(searchStats.peakVisited, searchStats.nodesExpanded);           // Every expanded state was marked visited once
+  peakStat(searchStats.bytesAllocated, frontierBytes + visited.bytes() + parents.bytes());
+}
+
+// Records the memory held by a best-first search once it is over, the open
+// list being estimated from its peak size
+template <typename Node>
+void finishBestFirstSearch(const vector<Node> &nodes, const PackedHashMap<int> &bestNode) {
+  chargeTime(searchStats.bookkeepingSeconds);
+  peakStat(searchStats.peakVisited, bestNode.size());
+  peakStat(searchStats.bytesAllocated, nodes.capacity() * sizeof(Node) + bestNode.bytes() +
+                                           searchStats.peakFrontier * sizeof(OpenEntry));
+}
+
+// -------------- Frontier Policies --------------
+// Take the entries of a visited policy and hand them back in search order.
+
+// Last in, first out: depth-first order
+class StackFrontier {
+ public:
+  explicit StackFrontier(vector<PackedState> &items) : items(items) {}
+
+  bool empty() const { return items.empty(); }
+  size_t size() const { return items.size(); }
+  size_t bytes() const { return items.capacity() * sizeof(PackedState); }
+  void push(PackedState state) { items.push_back(state); }
+
+  PackedState pop() {
+    PackedState state = items.back();
+    items.pop_back();
+    return state;
+  }
+
+ private:
+  vector<PackedState> &items;
+};
+
+// First in, first out: breadth-first order. Popped entries stay in the
+// vector behind the head, so the queue never moves its contents.
+class QueueFrontier {
+ public:
+  explicit QueueFrontier(vector<PackedState> &items) : items(items) {}
+
+  bool empty() const { return head == items.size(); }
+  size_t size() const { return items.size() - head; }
+  size_t bytes() const { return items.capacity() * sizeof(PackedState); }
+  void push(PackedState state) { items.push_back(state); }
+  PackedState pop() { return items[head++]; }
+
+ private:
+  vector<PackedState> &items;
+  size_t head = 0;                                                        // Index of the front of the queue
+};
+
+// Lowest f first, ties towards the deeper node: best-first order, over
+// either open list of open_list.h
+template <typename OpenList>
+class OrderedFrontier {
+ public:
+  explicit OrderedFrontier(OpenList &list) : list(list) {}
+
+  bool empty() const { return list.empty(); }
+  size_t size() const { return list.size(); }
+  size_t bytes() const { return list.bytes(); }
+  void push(const OpenEntry &entry) { list.push(entry); }
+
+  OpenEntry pop() {
+    OpenEntry entry = list.top();
+    list.pop();
+    return entry;
+  }
+
+ private:
+  OpenList &list;
+};
+
+// -------------- Visited Policies --------------
+// Record the states a search reaches and decide which children enter the
+// frontier. Each one defines the Entry its frontier holds, and may refuse to
+// expand a state it has closed (canExpand) to end the search early.
+
+/**
+ * @title Closed Rank Set
+ * @brief One visited bit and one parent byte per permutation rank. A state
+ * is expanded the first time it is popped and never again, and its parent is
+ * the last state that pushed it before that, so paths are only optimal when
+ * the frontier pops states in order of depth. Ranks only exist for the
+ * 8-puzzle, so the encoding is PackedEncoding.
+ */
+class ClosedRankSet {
+ public:
+  using Entry = PackedState;
+
+  ClosedRankSet(RankBitset &visited, RankParents &parents) : visited(visited), parents(parents) {}
+
+  template <typename Frontier>
+  void start(PackedState root, int, Frontier &frontier) {
+    visited.clear();
+    initial = root;
+    frontier.push(root);
+  }
+
+  bool close(PackedState entry, PackedState &state) {                     // false if the state was expanded already
+    state = entry;
+    return visited.insert(rankPacked(entry));
+  }
+
+  template <typename Frontier>
+  bool canExpand(const Frontier &) const { return true; }
+
+  template <typename Heuristic, typename Frontier>
+  void expand(PackedState state, const PackedState *children, int childCount, const Heuristic &, Frontier &frontier) {
+    for (int i = 0; i < childCount; ++i) {
+      uint32_t childRank = rankPacked(children[i]);
+      if (!visited.test(childRank)) {                                     // Check if the child is not visited
+        frontier.push(children[i]);                                       // Add the child to the frontier
+        parents.set(childRank, state.blankIndex());                       // Record the parent state
+      } else {
+        countStat(searchStats.duplicateHits);
+      }
+    }
+  }
+
+  MoveSequence moves(PackedState goalEntry) const { return reconstructMoves(parents, initial, goalEntry); }
+
+  template <typename Frontier>
+  void finish(const Frontier &frontier) const {
+    finishRankSearch(frontier.bytes(), visited, parents);
+  }
+
+ private:
+  RankBitset &visited;
+  RankParents &parents;
+  PackedState initial;
+};
+
+/**
+ * @title Node Pool
+ * @brief Nodes live in a pool and point to their parent by index, with g
+ * and h computed once per node, and a hash map keeps the cheapest node of
+ * every state. A state reached again more cheaply is reopened with a new
+ * node, which makes the node the map points to the only live one: entries of
+ * older nodes are skipped when popped. The children of an expansion are
+ * scored together by the encoding, in one call.
+ */
+template <typename Encoding>
+class NodePool {
+ public:
+  using Entry = OpenEntry;
+  using State = typename Encoding::State;
+  using Node = typename Encoding::Node;
+
+  NodePool(vector<Node> &nodes, PackedHashMap<int> &bestNode) : nodes(nodes), bestNode(bestNode) {}
+
+  template <typename Frontier>
+  void start(const State &root, int rootH, Frontier &frontier) {
+    nodes.push_back(Encoding::node(root, -1, 0, rootH));
+    bestNode[Encoding::hashKey(root)] = 0;
+    frontier.push({rootH, 0, 0});
+  }
+
+  bool close(const OpenEntry &entry, State &state) {                      // false if a cheaper path was found later
+    current = entry.node;
+    state = Encoding::state(nodes[current]);
+    return *bestNode.find(Encoding::hashKey(state)) == current;
+  }
+
+  template <typename Frontier>
+  bool canExpand(const Frontier &) const { return true; }
+
+  template <typename Heuristic, typename Frontier>
+  void expand(const State &, const State *children, int childCount, const Heuristic &heuristic, Frontier &frontier) {
+    State created[4];                                                     // Children that get a node, in pool order
+    int createdH[4];                                                      // Their h, -1 until scored
+    State fresh[4];                                                       // Children seen for the first time
+    int freshH[4];
+    int createdCount = 0, freshCount = 0;
+    int childG = nodes[current].g + 1;
+    for (int i = 0; i < childCount; ++i) {
+      bool inserted;
+      int &known = bestNode.insert(Encoding::hashKey(children[i]), int(nodes.size()) + createdCount, inserted);
+      if (inserted) {
+        fresh[freshCount++] = children[i];                                // First time this state is seen, scored below
+        createdH[createdCount] = -1;
+      } else {
+        if (nodes[known].g <= childG) {                                   // Not an improvement over the known path
+          countStat(searchStats.duplicateHits);
+          continue;
+        }
+        createdH[createdCount] = nodes[known].h;                          // Reopen the state, its h is unchanged
+        known = int(nodes.size()) + createdCount;
+      }
+      created[createdCount++] = children[i];
+    }
+
+    chargeTime(searchStats.bookkeepingSeconds);
+    Encoding::scoreChildren(heuristic, nodes[current], fresh, freshCount, freshH);
+    chargeTime(searchStats.heuristicSeconds);
+    for (int i = 0, next = 0; i < createdCount; ++i) {
+      int childH = createdH[i] < 0 ? freshH[next++] : createdH[i];
+      frontier.push({childG + childH, childG, int(nodes.size())});       // Add the child to the frontier
+      nodes.push_back(Encoding::node(created[i], current, childG, childH));
+    }
+  }
+
+  MoveSequence moves(const OpenEntry &goalEntry) const { return reconstructMoves<Encoding>(nodes, goalEntry.node); }
+
+  template <typename Frontier>
+  void finish(const Frontier &) const {
+    finishBestFirstSearch(nodes, bestNode);
+  }
+
+ protected:
+  vector<Node> &nodes;
+  PackedHashMap<int> &bestNode;
+  int current = -1;                                                       // Node being expanded
+};
+
+/**
+ * @title Graph Search
+ * @brief The loop every best-first and blind engine shares: pop an entry,
+ * skip it if its state was already dealt with, stop at the goal, otherwise
+ * expand it unless the visited policy calls the search off. The policies
+ * supply everything else, and since each is a template argument, every
+ * combination is compiled into its own loop with the encoding, the
+ * frontier, the visited checks and the heuristic inlined.
+ *
+ * @param initial The initial state, in the encoding's form.
+ * @param frontier StackFrontier, QueueFrontier or OrderedFrontier, empty.
+ * @param visited ClosedRankSet or a NodePool of the same encoding, over
+ * cleared storage.
+ * @param heuristic A functor the encoding scores with: one of
+ * simd_heuristics.h for PackedEncoding (ZeroHeuristic for the uninformed
+ * searches), one of ida_search.h for BoardEncoding.
+ * @param moves Set to the moves from the initial state to the goal state.
+ * @return true if the goal state was reached.
+ */
+template <typename Encoding, typename Frontier, typename Visited, typename Heuristic>
+bool graphSearch(const typename Encoding::State &initial, Frontier &frontier, Visited &visited, const Heuristic &heuristic,
+                 MoveSequence &moves) {
+  moves.clear();
+  const typename Encoding::State goalState = Encoding::goal();
+  typename Encoding::State state, children[4];
+
+  startStats();
+  int rootH = 0;
+  if constexpr (Heuristic::informed) {
+    rootH = Encoding::score(heuristic, initial);
+    chargeTime(searchStats.heuristicSeconds);
+  }
+  visited.start(initial, rootH, frontier);
+
+  while (!frontier.empty()) {
+    typename Visited::Entry entry = frontier.pop();
+    if (!visited.close(entry, state)) {
+      countStat(searchStats.duplicateHits);                               // Expanded already, or superseded
+      continue;
+    }
+
+    if (state == goalState) {
+      visited.finish(frontier);
+      moves = visited.moves(entry);                                       // Goal found!
+      return true;
+    }
+    if (!visited.canExpand(frontier)) break;                              // Out of budget, or stopped
+
+    countStat(searchStats.nodesExpanded);
+    chargeTime(searchStats.bookkeepingSeconds);
+    int childCount = Encoding::children(state, children);
+    countStat(searchStats.nodesGenerated, childCount);
+    chargeTime(searchStats.expansionSeconds);
+    visited.expand(state, children, childCount, heuristic, frontier);
+    peakStat(searchStats.peakFrontier, frontier.size());
+  }
+
+  visited.finish(frontier);
+  return false;                                                           // No solution found, or called off
+}
@@ -0,0 +1,253 @@
+// Iterative deepening A* for any W x H puzzle, the engine behind
+// idaStarSearch and the larger boards of batch mode.
+#pragma once
+
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+
+#include "packed.h"
+#include "pattern_db.h"
+#include "puzzle.h"
+#include "search_stats.h"
+#include "search_stop.h"
+#include "simd_heuristics.h"
+
+using namespace std;
+
+// -------------- Board Heuristics --------------
+// One functor per heuristic of the menu for W x H boards, so that a search
+// templated on it inlines the scoring instead of switching on the number for
+// every board. Each one scores a whole board (operator()), a board whose
+// Manhattan distance and misplaced tiles are already known (withCounts, for
+// IdaSearch) and the child of a scored board (afterMove: the tile slid from
+// cell from to cell to, giving the board of key childKey). incremental is
+// true when afterMove is a table delta rather than a new scoring.
+// Only heuristics 1 and 2 follow IdaSearch to another goal, since they read
+// nothing but the counts it keeps for that goal.
+
+template <int W, int H>
+struct BoardMisplacedHeuristic {                                          // Heuristic 1
+  static constexpr bool informed = true, incremental = true;
+  int operator()(const Board<W, H> &board) const { return boardMisplaced(board); }
+  int withCounts(const Board<W, H> &, int, int misplaced) const { return misplaced; }
+  int afterMove(int h, int tile, int from, int to, uint64_t) const {
+    return h + puzzleTables<W, H>.misplaced[tile][to] - puzzleTables<W, H>.misplaced[tile][from];
+  }
+};
+
+template <int W, int H>
+struct BoardManhattanHeuristic {                                          // Heuristic 2
+  static constexpr bool informed = true, incremental = true;
+  int operator()(const Board<W, H> &board) const { return boardManhattan(board); }
+  int withCounts(const Board<W, H> &, int manhattan, int) const { return manhattan; }
+  int afterMove(int h, int tile, int from, int to, uint64_t) const {
+    return h + puzzleTables<W, H>.manhattan[tile][to] - puzzleTables<W, H>.manhattan[tile][from];
+  }
+};
+
+template <int W, int H>
+struct BoardSequenceHeuristic {                                           // Heuristic 3, H = totdist + 3 * seq
+  static constexpr bool informed = true, incremental = false;
+  int operator()(const Board<W, H> &board) const { return boardManhattan(board) + 3 * boardSequenceScore(board); }
+  int withCounts(const Board<W, H> &board, int manhattan, int) const {
+    return manhattan + 3 * boardSequenceScore(board);                     // The ring scan does not allocate
+  }
+  int afterMove(int, int, int, int, uint64_t childKey) const { return (*this)(unpackBoardKey<W, H>(childKey)); }
+};
+
+template <int W, int H>
+struct BoardPatternHeuristic {                                            // Heuristic 4, the additive pattern database
+  static constexpr bool informed = true, incremental = false;
+  const PatternDatabase<W, H> &database = defaultPatternDatabase<W, H>();
+  int operator()(const Board<W, H> &board) const { return database.evaluate(board); }
+  int withCounts(const Board<W, H> &board, int, int) const { return database.evaluate(board); } // Table lookups, no allocation
+  int afterMove(int, int, int, int, uint64_t childKey) const { return database.evaluate(unpackBoardKey<W, H>(childKey)); }
+};
+
+// Calls visit with the W x H functor of a heuristic numbered as in the menu,
+// once per search
+template <int W, int H, typename Visit>
+auto withBoardHeuristic(int heuristicType, Visit &&visit) {
+  return withHeuristicNumber(heuristicType, [&](auto number) {
+    if constexpr (decltype(number)::value == 1) return visit(BoardMisplacedHeuristic<W, H>());
+    else if constexpr (decltype(number)::value == 2) return visit(BoardManhattanHeuristic<W, H>());
+    else if constexpr (decltype(number)::value == 4) return visit(BoardPatternHeuristic<W, H>());
+    else return visit(BoardSequenceHeuristic<W, H>());
+  });
+}
+
+// Heuristic of one board, numbered as in the menu, for one-off scoring
+template <int W, int H>
+int boardHeuristic(const Board<W, H> &board, int heuristicType) {
+  return withBoardHeuristic<W, H>(heuristicType, [&](const auto &heuristic) { return heuristic(board); });
+}
+
+// -------------- Iterative Deepening A* --------------
+const int idaMaxDepth = 256;                                              // Deepest path IDA* will explore
+const int idaFound = -1;                                                  // Returned by the recursion once the goal is reached
+const int idaInfinity = 1 << 30;                                          // Threshold when no node exceeded the bound
+
+/**
+ * @title Iterative Deepening A* Search
+ * @brief Recursion state of IDA*, kept on the caller's stack. Moves are made
+ * and undone on one board, Manhattan distance and misplaced tiles are updated
+ * from the moved tile alone, and the move undoing the previous one is skipped.
+ * With a stop set, the search polls it every stopCheckInterval expansions
+ * and unwinds as soon as it is requested.
+ */
+template <int W, int H, typename Heuristic>
+struct IdaSearch {
+  Board<W, H> board;                                                      // Single board updated in place
+  Heuristic scorer;
+  const PuzzleTables<W, H> *goalTables = &puzzleTables<W, H>;             // Tables of the goal searched for
+  int manhattan;                                                          // Maintained incrementally
+  int misplaced;                                                          // Maintained incrementally
+  int moves[idaMaxDepth];                                                 // Blank index after each move of the current path
+  int solutionLength;                                                     // Number of moves once the goal is found
+  const SearchStop *stop = nullptr;                                       // Polled during the search if set
+  int sinceCheck;                                                         // Expansions since the last poll
+  bool stopped;                                                           // The stop was requested, unwinding
+
+  void reset(const Board<W, H> &start) {
+    board = start;
+    manhattan = boardManhattan(board, *goalTables);
+    misplaced = boardMisplaced(board, *goalTables);
+    solutionLength = 0;
+    sinceCheck = 0;
+    stopped = false;
+  }
+
+  int heuristic() const { return scorer.withCounts(board, manhattan, misplaced); }
+
+  void makeMove(int newBlank) {                                           // Slides the tile at newBlank into the blank
+    const PuzzleTables<W, H> &tables = *goalTables;
+    int tile = board.tiles[newBlank];
+    manhattan += tables.manhattan[tile][board.blank] - tables.manhattan[tile][newBlank];
+    misplaced += tables.misplaced[tile][board.blank] - tables.misplaced[tile][newBlank];
+    board.tiles[board.blank] = tile;
+    board.tiles[newBlank] = 0;
+    board.blank = newBlank;
+  }
+
+  int search(int g, int threshold, int previousBlank) {                   // Bounded depth-first search below the current board
+    chargeTime(searchStats.bookkeepingSeconds);
+    int f = g + heuristic();
+    chargeTime(searchStats.heuristicSeconds);
+    if (f > threshold) return f;                                          // Over the bound, report how far over
+    if (manhattan == 0) {                                                 // Every tile is home
+      solutionLength = g;
+      return idaFound;
+    }
+    if (g == idaMaxDepth) return idaInfinity;
+
+    if (stop != nullptr && ++sinceCheck == stopCheckInterval) {
+      sinceCheck = 0;
+      stopped = stop->requested();
+    }
+    if (stopped) return idaInfinity;
+
+    countStat(searchStats.nodesExpanded);
+    peakStat(searchStats.peakFrontier, g + 1);                            // Boards on the recursion stack
+    int nextThreshold = idaInfinity;
+    const int8_t *neighbors = puzzleTables<W, H>.neighbors[board.blank];
+    for (int d = 0; d < 4; ++d) {
+      int newBlank = neighbors[d];
+      if (newBlank < 0 || newBlank == previousBlank) continue;            // Off the board, or undoing the last move
+
+      int oldBlank = board.blank;
+      makeMove(newBlank);
+      moves[g] = newBlank;
+      countStat(searchStats.nodesGenerated);
+      chargeTime(searchStats.expansionSeconds);
+      int result = search(g + 1, threshold, oldBlank);
+      if (result == idaFound) return idaFound;                            // Leave the board at the goal
+      makeMove(oldBlank);                                                 // Undo the move
+      nextThreshold = min(nextThreshold, result);
+    }
+    return nextThreshold;
+  }
+
+  // Deepens until the goal is found, false if it is out of reach or the stop
+  // was requested. A known lower bound on the solution length skips the
+  // iterations below it.
+  bool run(int lowerBound = 0) {
+    if (isBoardSolvable(board) != isBoardSolvable(makeBoard<W, H>(goalTables->goal))) return false; // Would never terminate
+    int threshold = max(heuristic(), lowerBound);
+    int result;
+    while ((result = search(0, threshold, -1)) != idaFound) {
+      if (stopped || result >= idaInfinity) return false;                 // Stopped, or nothing within idaMaxDepth moves
+      threshold = result;                                                 // Deepen to the smallest f that was cut off
+    }
+    return true;
+  }
+};
+
+// Runs IDA* on board from a known lower bound on the solution length,
+// filling blankPath with the blank index after each move, without starting
+// the statistics. The heuristic is picked here, once.
+template <int W, int H>
+bool idaDeepen(const Board<W, H> &board, int heuristicType, const SearchStop *stop, int lowerBound, vector<int> &blankPath) {
+  return withBoardHeuristic<W, H>(heuristicType, [&](const auto &heuristic) {
+    IdaSearch<W, H, decay_t<decltype(heuristic)>> search{board, heuristic};
+    search.reset(board);
+    search.stop = stop;
+    if (!search.run(lowerBound)) return false;
+    blankPath.assign(search.moves, search.moves + search.solutionLength);
+    return true;
+  });
+}
+
+// Solves board with IDA*, filling blankPath with the blank index after each
+// move, and gives up once stop (if any) is requested
+template <int W, int H>
+bool idaStar(const Board<W, H> &board, int heuristicType, vector<int> &blankPath, const SearchStop *stop = nullptr) {
+  startStats();
+  blankPath.clear();
+  bool found = idaDeepen(board, heuristicType, stop, 0, blankPath);
+  chargeTime(searchStats.bookkeepingSeconds);
+  peakStat(searchStats.bytesAllocated, blankPath.size() * sizeof(int));  // Only the returned path is on the heap
+  return found;
+}
+
+/**
+ * @title IDA* Toward Any Goal
+ * @brief Solves board for a goal that no rotation or reflection maps onto
+ * the standard goal, which canonicalBoard needs, by running IDA* against
+ * tables built for that goal. The distance and pattern databases, the
+ * sequence score and the solution caches all assume the standard goal, so
+ * none is used: heuristic 1 stays the misplaced tiles and every other number
+ * gives the Manhattan distance, both counted toward the goal.
+ *
+ * @param board The board to solve.
+ * @param goal The goal, any board of the same size.
+ * @param heuristicType The heuristic asked for, as numbered in the menu.
+ * @param blankPath Filled with the blank index after each move.
+ * @param stop Polled during the search if set.
+ * @return true if a path was found, false if the goal is out of reach or the
+ * search was stopped.
+ */
+template <int W, int H>
+bool idaStarToGoal(const Board<W, H> &board, const Board<W, H> &goal, int heuristicType, vector<int> &blankPath,
+                   const SearchStop *stop = nullptr) {
+  startStats();
+  blankPath.clear();
+  int goalTiles[W * H];
+  copy(goal.tiles, goal.tiles + W * H, goalTiles);
+  const PuzzleTables<W, H> tables(goalTiles);
+  auto deepen = [&](const auto &heuristic) {
+    IdaSearch<W, H, decay_t<decltype(heuristic)>> search{board, heuristic, &tables};
+    search.reset(board);
+    search.stop = stop;
+    if (!search.run()) return false;
+    blankPath.assign(search.moves, search.moves + search.solutionLength);
+    return true;
+  };
+  bool found = withHeuristicNumber(heuristicType, [&](auto number) {
+    if constexpr (decltype(number)::value == 1) return deepen(BoardMisplacedHeuristic<W, H>());
+    else return deepen(BoardManhattanHeuristic<W, H>());
+  });
+  chargeTime(searchStats.bookkeepingSeconds);
+  peakStat(searchStats.bytesAllocated, blankPath.size() * sizeof(int));  // Only the returned path is on the heap
+  return found;
+}
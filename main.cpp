@@ -1,10 +1,27 @@
 #include "functions.h"
+#include "batch.h"
+#include "distance_db.h"
+#include "server.h"
+
+const chrono::milliseconds menuTimeLimit(1000);                           // Time the anytime search gets in the menu
+
+int main(int argc, char *argv[]) {
+  for (int i = 1; i < argc; ++i) {                           // --serve selects the resident server mode
+    if (string(argv[i]) != "--serve") continue;
+    ServerOptions options;
+    if (!parseServerOptions(argc, argv, options)) return 1;
+    return runServer(options);
+  }
+  if (argc > 1) {                                            // Any other flag selects the non-interactive batch mode
+    BatchOptions options;
+    if (!parseBatchOptions(argc, argv, options)) return 1;
+    return runBatch(options);
+  }
 
-int main() {
   int input[9];
-  int temp;
   int choice;
   int heuristic;
+  DistanceDatabase database;                                 // Mapped on first use of the distance database mode
 
   // Greating and instructions
   cout << "\nWelcome to the 8-puzzle solver program! \n";
@@ -18,9 +35,11 @@ int main() {
   cout << "Please enter your 8-puzzle : ";
 
   // ... (Get starting state from user) ...
-  for (int i = 0; i < 9; ++i) {
-    cin >> temp;
-    input[i] = temp;
+  string line;
+  while (true) {
+    if (!getline(cin, line)) return 0;                       // Input closed before a board was given
+    if (parseBoard(line, input)) break;                      // Every tile from 0 to 8 exactly once
+    cout << "Please enter each number from 0 to 8 exactly once : ";
   }
 
   // ... (Create starting state) ...
@@ -43,13 +62,18 @@ int main() {
     cout << "1. Depth First Search \n";
     cout << "2. Breadth First Search \n";
     cout << "3. Best-First Search \n";
-    cout << "4. End program \n";
+    cout << "4. Iterative Deepening A* \n";
+    cout << "5. Bidirectional Breadth First Search \n";
+    cout << "6. Distance Database Lookup \n";
+    cout << "7. Parallel Best-First Search (HDA*) \n";
+    cout << "8. Anytime Best-First Search (ARA*) \n";
+    cout << "9. End program \n";
 
     while (true) {
       cout << endl << "Enter your choice using a number: ";
       cin >> choice;
 
-      if (cin.fail() || choice == 0 || choice > 4) {         // If the input is not a number
+      if (cin.fail() || choice == 0 || choice > 9) {         // If the input is not a number
         cin.clear();            // Clear the input buffer
         cin.ignore(1000, '\n'); // Ignore the rest of the input
         cout << "\nInvalid input. Please try again.\n";
@@ -64,10 +88,11 @@ int main() {
 
       cout << "Solving with Depth First Search... \n";
       vector<State> dFSPath = depthFirstSearch(userState);
-      int dFSNodes = dFSPath.size();
+      string dFSNodes = expandedNodes();                                // States the search expanded
 
       cout << "Depth First Search completed! \n";
       cout << "Number of Nodes: " << dFSNodes << endl;
+      cout << "Search statistics: " << searchStats.toJson() << endl;
       cout << "Path from the intial state to the goal: \n";
       for (int i = 0; i < dFSPath.size(); i += 10) {                  // Print the path in groups of 10
           vector<State> states;
@@ -81,10 +106,11 @@ int main() {
 
       cout << "Solving with Breadth First Search... \n";
       vector<State> bFSPath = breadthFirstSearch(userState);
-      int bFSNodes = bFSPath.size();
+      string bFSNodes = expandedNodes();                                // States the search expanded
 
       cout << "Breadth First Search completed! \n";
       cout << "Number of Nodes: " << bFSNodes << endl;
+      cout << "Search statistics: " << searchStats.toJson() << endl;
       cout << "Path from the intial state to the goal: \n";
       for (int i = 0; i < bFSPath.size(); i += 10) {                  // Print the path in groups of 10
           vector<State> states;
@@ -94,21 +120,26 @@ int main() {
           printStates(states);
       }
 
-    } else if (choice == 3) { // Best-First Search
+    } else if (choice == 3 || choice == 4 || choice == 7 || choice == 8) { // Best-First Search, IDA*, HDA* or ARA*
 
+      string searchName = choice == 3   ? "Best-First Search"
+                          : choice == 4 ? "Iterative Deepening A*"
+                          : choice == 7 ? "Parallel Best-First Search"
+                                        : "Anytime Best-First Search";
       do {
 
         cout << "Please select a heuristic: \n";
         cout << "1. Number of misplaced tiles \n";
         cout << "2. Manhattan distance \n";
         cout << "3. The Heuristic H (H = totdist + 3*seq) \n";
-        cout << "4. Go back \n";
+        cout << "4. Pattern database \n";
+        cout << "5. Go back \n";
 
         while (true) {
           cout << endl << "Enter your choice using a number: ";
           cin >> heuristic;
 
-          if (cin.fail() || heuristic == 0 || heuristic > 4) {         // If the input is not a number
+          if (cin.fail() || heuristic == 0 || heuristic > 5) {         // If the input is not a number
             cin.clear();            // Clear the input buffer
             cin.ignore(1000, '\n'); // Ignore the rest of the input
             cout << "\nInvalid input. Please try again.\n";
@@ -119,14 +150,20 @@ int main() {
           }
         }
 
-        if (heuristic == 1) { // Number of misplaced tiles
+        if (heuristic >= 1 && heuristic <= 4) { // Misplaced tiles, Manhattan distance, the Heuristic H or pattern database
 
-          cout << "Solving with Best-First Search, Heuristic 1... \n";
-          vector<State> bestFSPath = bestFirstSearch(userState, heuristic);
-          int bestFSNodes = bestFSPath.size();
+          cout << "Solving with " << searchName << ", Heuristic " << heuristic << "... \n";
+          double bound = 1;                                            // Proven suboptimality of the ARA* path
+          vector<State> bestFSPath = choice == 3   ? bestFirstSearch(userState, heuristic)
+                                     : choice == 4 ? idaStarSearch(userState, heuristic)
+                                     : choice == 7 ? parallelBestFirstSearch(userState, heuristic, max(1u, thread::hardware_concurrency()))
+                                                   : anytimeBestFirstSearch(userState, heuristic, menuTimeLimit, bound);
+          string bestFSNodes = expandedNodes();                         // States the search expanded
 
-          cout << "Best-First Search completed! \n";
+          cout << searchName << " completed! \n";
           cout << "Number of Nodes: " << bestFSNodes << endl;
+          if (choice == 8) cout << "Suboptimality bound: " << bound << endl;
+          cout << "Search statistics: " << searchStats.toJson() << endl;
           cout << "Path from the intial state to the goal: \n";
           for (int i = 0; i < bestFSPath.size(); i += 10) {                  // Print the path in groups of 10
               vector<State> states;
@@ -136,54 +173,61 @@ int main() {
               printStates(states);
           }
 
-        } else if (heuristic == 2) { // Manhattan distance
+        } else if (heuristic == 5) { // Go back
+          break;
+        } else {
+          cout << "Invalid input. Please try again. \n";
+        }
 
-          cout << "Solving with Best-First Search, Heuristic 2... \n";
-          vector<State> bestFSPath = bestFirstSearch(userState, heuristic);
-          int bestFSNodes = bestFSPath.size();
+      } while (heuristic != 5);
 
-          cout << "Best-First Search completed! \n";
-          cout << "Number of Nodes: " << bestFSNodes << endl;
-          cout << "Path from the intial state to the goal: \n";
-          for (int i = 0; i < bestFSPath.size(); i += 10) {                  // Print the path in groups of 10
-              vector<State> states;
-              for (int j = i; j < i + 10 && j < bestFSPath.size(); ++j) {
-                  states.push_back(bestFSPath[j]);
-              }
-              printStates(states);
-          }
-
-        } else if (heuristic == 3) { // The Heuristic H (H = totdist + 3*seq
+    } else if (choice == 5) { // Bidirectional Breadth First Search
 
-          cout << "Solving with Best-First Search, Heuristic 3... \n";
-          vector<State> bestFSPath = bestFirstSearch(userState, heuristic); 
-          int bestFSNodes = bestFSPath.size();
+      cout << "Solving with Bidirectional Breadth First Search... \n";
+      vector<State> biPath = bidirectionalSearch(userState);
+      string biNodes = expandedNodes();                                 // States the search expanded
 
-          cout << "Best-First Search completed! \n";
-          cout << "Number of Nodes: " << bestFSNodes << endl;
-          cout << "Path from the intial state to the goal: \n";
-          for (int i = 0; i < bestFSPath.size(); i += 10) {                  // Print the path in groups of 10
-              vector<State> states;
-              for (int j = i; j < i + 10 && j < bestFSPath.size(); ++j) {
-                  states.push_back(bestFSPath[j]);
-              }
-              printStates(states);
+      cout << "Bidirectional Breadth First Search completed! \n";
+      cout << "Number of Nodes: " << biNodes << endl;
+      cout << "Search statistics: " << searchStats.toJson() << endl;
+      cout << "Path from the intial state to the goal: \n";
+      for (size_t i = 0; i < biPath.size(); i += 10) {                // Print the path in groups of 10
+          vector<State> states;
+          for (size_t j = i; j < i + 10 && j < biPath.size(); ++j) {
+              states.push_back(biPath[j]);
           }
+          printStates(states);
+      }
 
-        } else if (heuristic == 4) { // Go back
-          break;
-        } else {
-          cout << "Invalid input. Please try again. \n";
-        }
+    } else if (choice == 6) { // Distance Database Lookup
+
+      if (!database.isLoaded() && !database.open("distances.db")) {
+        cout << "Could not open distances.db, create it with build_distance_db first. \n";
+        continue;
+      }
+
+      cout << "Solving with the Distance Database... \n";
+      vector<State> dbPath = distanceDatabaseSearch(userState, database);
+      string dbNodes = expandedNodes();                                 // States the search expanded
 
-      } while (heuristic != 4);
+      cout << "Distance Database Lookup completed! \n";
+      cout << "Number of Nodes: " << dbNodes << endl;
+      cout << "Search statistics: " << searchStats.toJson() << endl;
+      cout << "Path from the intial state to the goal: \n";
+      for (size_t i = 0; i < dbPath.size(); i += 10) {                // Print the path in groups of 10
+          vector<State> states;
+          for (size_t j = i; j < i + 10 && j < dbPath.size(); ++j) {
+              states.push_back(dbPath[j]);
+          }
+          printStates(states);
+      }
 
-    } else if (choice == 4) { // End program
+    } else if (choice == 9) { // End program
       cout << "Goodbye! \n";
       return 0;
     } else {
       cout << "Invalid input. Please try again. \n";
     }
 
-  } while (choice != 4);
+  } while (choice != 9);
 }
@@ -0,0 +1,103 @@
+// Compact paths: the direction the blank moves in at every step, 2 bits per
+// move, which the solvers return alongside (or instead of) their states.
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "puzzle.h"
+
+using namespace std;
+
+// Letters for the blank moves Up, Down, Left, Right, in direction order
+const char moveLetters[4] = {'U', 'D', 'L', 'R'};
+
+// Direction (index into PuzzleTables::neighbors) that slides the blank from
+// one cell to a neighbouring one, -1 if the cells are not adjacent
+template <int W, int H>
+int moveDirection(int from, int to) {
+  for (int d = 0; d < 4; ++d) {
+    if (puzzleTables<W, H>.neighbors[from][d] == to) return d;
+  }
+  return -1;
+}
+
+/**
+ * @title Move Sequence
+ * @brief Path as the direction of every move of the blank, 0 to 3 for Up,
+ * Down, Left and Right as in PuzzleTables::neighbors, packed 32 moves to a
+ * 64-bit word with the first move in the low bits. A 31-move 8-puzzle
+ * solution takes one word where its vector<State> takes 1.8 KB, and the
+ * boards along the path follow from the initial board alone.
+ */
+class MoveSequence {
+ public:
+  size_t size() const { return length; }
+  bool empty() const { return length == 0; }
+  size_t bytes() const { return words.capacity() * sizeof(uint64_t); }   // Heap memory held
+
+  void clear() {                                                          // Keeps the words' memory
+    words.clear();
+    length = 0;
+  }
+
+  void push(int direction) {
+    if (length % movesPerWord == 0) words.push_back(0);
+    words.back() |= uint64_t(direction) << (2 * (length % movesPerWord));
+    ++length;
+  }
+
+  int operator[](size_t i) const { return (words[i / movesPerWord] >> (2 * (i % movesPerWord))) & 3; }
+
+  void reverse() {                                                        // Paths rebuilt from the goal end come out backwards
+    for (size_t i = 0; i < length / 2; ++i) {
+      size_t j = length - 1 - i;
+      int first = (*this)[i], last = (*this)[j];
+      set(i, last);
+      set(j, first);
+    }
+  }
+
+  // One letter per move, e.g. "ULDR"
+  string toString() const {
+    string letters(length, ' ');
+    for (size_t i = 0; i < length; ++i) letters[i] = moveLetters[(*this)[i]];
+    return letters;
+  }
+
+  // Moves 4 * b to 4 * b + 3 in one byte, first move in the low bits, for
+  // b below (size() + 3) / 4
+  uint8_t packedByte(size_t b) const { return uint8_t(words[b / 8] >> (8 * (b % 8))); }
+
+  // Moves of a path given as the blank index after each move
+  template <int W, int H>
+  static MoveSequence fromBlankPath(int blank, const vector<int> &blankPath) {
+    MoveSequence moves;
+    moves.words.reserve((blankPath.size() + movesPerWord - 1) / movesPerWord);
+    for (int next : blankPath) {
+      moves.push(moveDirection<W, H>(blank, next));
+      blank = next;
+    }
+    return moves;
+  }
+
+  // The blank index after each move, starting from the given blank index
+  template <int W, int H>
+  vector<int> toBlankPath(int blank) const {
+    vector<int> blankPath(length);
+    for (size_t i = 0; i < length; ++i) blankPath[i] = blank = puzzleTables<W, H>.neighbors[blank][(*this)[i]];
+    return blankPath;
+  }
+
+ private:
+  static const size_t movesPerWord = 32;
+  vector<uint64_t> words;
+  size_t length = 0;
+
+  void set(size_t i, int direction) {
+    uint64_t &word = words[i / movesPerWord];
+    int shift = 2 * (i % movesPerWord);
+    word = (word & ~(uint64_t(3) << shift)) | (uint64_t(direction) << shift);
+  }
+};
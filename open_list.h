@@ -0,0 +1,91 @@
+// Open lists of the best-first engines. Both expose the push, top, pop,
+// empty and size of std::priority_queue plus a clear that keeps their memory,
+// so an engine takes either one as a template argument.
+#pragma once
+
+#include <queue>
+#include <vector>
+
+using namespace std;
+
+// Open list entry: lower f first, ties broken towards the deeper node
+struct OpenEntry {
+  int f, g;
+  int node;
+
+  bool operator<(const OpenEntry &other) const {                          // Reversed so priority_queue pops the best entry
+    if (f != other.f) return f > other.f;
+    return g < other.g;
+  }
+};
+
+// Binary heap, O(log n) push and pop
+class HeapQueue : public priority_queue<OpenEntry> {
+ public:
+  void clear() { c.clear(); }                                             // Keeps the heap's memory
+  size_t bytes() const { return c.capacity() * sizeof(OpenEntry); }      // Heap memory held
+};
+
+/**
+ * @title Bucket Queue
+ * @brief Open list for small integer f values: one bucket per f, split into
+ * one LIFO stack of node indices per g. Pushing appends to a stack, and
+ * popping takes from the stack of the highest g in the lowest non-empty f, so
+ * it pops entries in the same order as HeapQueue up to ties on both f and g.
+ * The cursors only move past empty stacks, which costs O(1) amortized when f
+ * never decreases along a path (consistent heuristics); an inconsistent
+ * heuristic can push below the cursor, which simply moves it back.
+ */
+class BucketQueue {
+ public:
+  bool empty() const { return count == 0; }
+  size_t size() const { return count; }
+
+  void clear() {                                                          // Keeps the stacks' memory
+    for (Bucket &bucket : buckets) {
+      for (int g = 0; g <= bucket.maxG; ++g) bucket.stacks[g].clear();
+      bucket.maxG = -1;
+    }
+    count = 0;
+  }
+
+  size_t bytes() const { return stackBytes + buckets.capacity() * sizeof(Bucket); } // Heap memory held, bar stack headers
+
+  void push(const OpenEntry &entry) {
+    if (entry.f >= int(buckets.size())) buckets.resize(entry.f + 1);
+    Bucket &bucket = buckets[entry.f];
+    if (entry.g >= int(bucket.stacks.size())) bucket.stacks.resize(entry.g + 1);
+    vector<int> &stack = bucket.stacks[entry.g];
+    size_t capacity = stack.capacity();
+    stack.push_back(entry.node);
+    stackBytes += (stack.capacity() - capacity) * sizeof(int);
+    bucket.maxG = max(bucket.maxG, entry.g);
+    if (count == 0 || entry.f < minF) minF = entry.f;
+    ++count;
+  }
+
+  OpenEntry top() const {                                                 // Only valid when not empty
+    const Bucket &bucket = buckets[minF];
+    return {minF, bucket.maxG, bucket.stacks[bucket.maxG].back()};
+  }
+
+  void pop() {                                                            // Only valid when not empty
+    Bucket &bucket = buckets[minF];
+    bucket.stacks[bucket.maxG].pop_back();
+    --count;
+    while (bucket.maxG >= 0 && bucket.stacks[bucket.maxG].empty()) --bucket.maxG;
+    if (count == 0) return;
+    while (buckets[minF].maxG < 0) ++minF;                                // Move on to the next non-empty bucket
+  }
+
+ private:
+  struct Bucket {
+    vector<vector<int>> stacks;                                           // Node indices by g
+    int maxG = -1;                                                        // Highest g with a non-empty stack, -1 if none
+  };
+
+  vector<Bucket> buckets;                                                 // Indexed by f
+  int minF = 0;                                                           // Lowest f with a non-empty bucket
+  size_t count = 0;
+  size_t stackBytes = 0;                                                  // Capacity of all stacks, kept by clear
+};
@@ -0,0 +1,222 @@
+// Packed board encoding and hash containers used by the search algorithms.
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "puzzle.h"
+
+using namespace std;
+
+// -------------- Packed Board Layout --------------
+// Cell i of the board lives in bits [4i, 4i + 4) of a uint64_t, the index of
+// the blank tile is cached in the top nibble (bits 60-63).
+const int packedCells = 9;                                                // Number of cells in the 8-puzzle
+const int packedBlankShift = 60;                                          // Bit offset of the cached blank index
+const uint64_t packedCellMask = 0xF;                                      // Mask for a single 4-bit cell
+
+// Blank moves per blank index in the order Up, Down, Left, Right, -1 if off the board
+const auto &blankMoves = puzzleTables<3, 3>.neighbors;
+
+struct PackedState {                                                      // 8-byte representation of an 8-puzzle board
+  uint64_t bits;
+
+  PackedState() : bits(0) {}
+  explicit PackedState(uint64_t value) : bits(value) {}
+
+  int tileAt(int index) const { return (bits >> (4 * index)) & packedCellMask; }
+  int blankIndex() const { return bits >> packedBlankShift; }
+
+  bool operator==(const PackedState &other) const { return bits == other.bits; }
+  bool operator!=(const PackedState &other) const { return bits != other.bits; }
+  bool operator<(const PackedState &other) const { return bits < other.bits; }
+};
+
+// Packs a 9-cell board into a PackedState, caching the blank index
+PackedState packBoard(const int board[9]) {
+  uint64_t bits = 0;
+  int blank = 0;
+  for (int i = 0; i < packedCells; ++i) {
+    bits |= uint64_t(board[i] & packedCellMask) << (4 * i);
+    if (board[i] == 0) blank = i;
+  }
+  bits |= uint64_t(blank) << packedBlankShift;
+  return PackedState(bits);
+}
+
+// Unpacks a PackedState back into a 9-cell board
+void unpackBoard(PackedState packed, int board[9]) {
+  for (int i = 0; i < packedCells; ++i) {
+    board[i] = packed.tileAt(i);
+  }
+}
+
+// Slides the tile at newBlank into the blank, constant time
+PackedState applyMove(PackedState packed, int newBlank) {
+  int blank = packed.blankIndex();
+  uint64_t tile = packed.tileAt(newBlank);
+  uint64_t bits = packed.bits;
+  bits &= ~(packedCellMask << (4 * newBlank));                            // Clear the tile's old cell (it becomes the blank)
+  bits |= tile << (4 * blank);                                            // Drop the tile into the old blank cell
+  bits &= ~(packedCellMask << packedBlankShift);                          // Update the cached blank index
+  bits |= uint64_t(newBlank) << packedBlankShift;
+  return PackedState(bits);
+}
+
+// 64-bit finalizer (splitmix64), spreads packed boards across the table
+uint64_t hashPacked(uint64_t key) {
+  key ^= key >> 30;
+  key *= 0xbf58476d1ce4e5b9ULL;
+  key ^= key >> 27;
+  key *= 0x94d049bb133111ebULL;
+  key ^= key >> 31;
+  return key;
+}
+
+/**
+ * @title Packed Hash Map
+ * @brief Open-addressing hash map (linear probing) keyed by packed boards.
+ * Every slot carries the epoch it was filled in and only slots of the current
+ * epoch hold entries, so clear empties the map in O(1) by starting a new
+ * epoch while keeping the table's memory. The table doubles once it is more
+ * than half full.
+ */
+template <typename V>
+class PackedHashMap {
+ public:
+  explicit PackedHashMap(size_t initialCapacity = 1024) { rehash(roundCapacity(initialCapacity)); }
+
+  size_t size() const { return count; }
+  size_t bytes() const {                                                  // Heap memory held
+    return keys.capacity() * sizeof(uint64_t) + values.capacity() * sizeof(V) + epochs.capacity();
+  }
+
+  size_t bytesAfterInserts(size_t extra) const {                          // Peak heap memory while inserting extra new keys
+    if ((count + extra) * 2 <= keys.size()) return bytes();
+    return 3 * bytes();                                                   // The old table and its doubled copy during rehash
+  }
+
+  void clear() {                                                          // Removes every entry, keeping the table
+    count = 0;
+    if (++epoch == 0) {                                                   // Epochs wrapped around, forget the old stamps
+      fill(epochs.begin(), epochs.end(), 0);
+      epoch = 1;
+    }
+  }
+
+  V *find(PackedState key) {                                              // Returns the value for key, or nullptr
+    size_t slot = hashPacked(key.bits) & mask;
+    while (epochs[slot] == epoch) {
+      if (keys[slot] == key.bits) return &values[slot];
+      slot = (slot + 1) & mask;
+    }
+    return nullptr;
+  }
+
+  bool contains(PackedState key) { return find(key) != nullptr; }
+
+  V &operator[](PackedState key) {                                        // Inserts a default value if key is missing
+    bool inserted;
+    return insert(key, V(), inserted);
+  }
+
+  V &insert(PackedState key, const V &value, bool &inserted) {            // Inserts value unless key is present
+    if ((count + 1) * 2 > keys.size()) rehash(keys.size() * 2);
+    size_t slot = hashPacked(key.bits) & mask;
+    while (epochs[slot] == epoch) {
+      if (keys[slot] == key.bits) {
+        inserted = false;
+        return values[slot];
+      }
+      slot = (slot + 1) & mask;
+    }
+    keys[slot] = key.bits;
+    values[slot] = value;
+    epochs[slot] = epoch;
+    ++count;
+    inserted = true;
+    return values[slot];
+  }
+
+ private:
+  vector<uint64_t> keys;
+  vector<V> values;
+  vector<uint8_t> epochs;                                                 // Epoch each slot was filled in
+  uint8_t epoch = 1;                                                      // Slots of other epochs are empty
+  size_t mask = 0;
+  size_t count = 0;
+
+  static size_t roundCapacity(size_t capacity) {
+    size_t result = 16;
+    while (result < capacity) result <<= 1;
+    return result;
+  }
+
+  void rehash(size_t capacity) {
+    vector<uint64_t> oldKeys;
+    vector<V> oldValues;
+    vector<uint8_t> oldEpochs;
+    oldKeys.swap(keys);
+    oldValues.swap(values);
+    oldEpochs.swap(epochs);
+    keys.assign(capacity, 0);
+    values.assign(capacity, V());
+    epochs.assign(capacity, 0);
+    mask = capacity - 1;
+    for (size_t i = 0; i < oldKeys.size(); ++i) {
+      if (oldEpochs[i] != epoch) continue;
+      size_t slot = hashPacked(oldKeys[i]) & mask;
+      while (epochs[slot] == epoch) slot = (slot + 1) & mask;
+      keys[slot] = oldKeys[i];
+      values[slot] = oldValues[i];
+      epochs[slot] = epoch;
+    }
+  }
+};
+
+// Open-addressing hash set of packed boards
+class PackedHashSet {
+ public:
+  explicit PackedHashSet(size_t initialCapacity = 1024) : map(initialCapacity) {}
+
+  size_t size() const { return map.size(); }
+  size_t bytes() const { return map.bytes(); }                            // Heap memory held
+  bool contains(PackedState key) { return map.contains(key); }
+  bool insert(PackedState key) {                                          // Returns true if key was not present
+    bool inserted;
+    map.insert(key, 1, inserted);
+    return inserted;
+  }
+  void clear() { map.clear(); }                                           // Removes every key, keeping the table
+
+ private:
+  PackedHashMap<uint8_t> map;
+};
+
+// -------------- Board Keys --------------
+// Packs a board of at most 16 cells into 4 bits per cell (never 0, tile 1 is somewhere)
+template <int W, int H>
+uint64_t packBoardKey(const Board<W, H> &board) {
+  static_assert(W * H <= 16, "packed keys hold at most 16 cells");
+  uint64_t key = 0;
+  for (int i = 0; i < W * H; ++i) key |= uint64_t(board.tiles[i]) << (4 * i);
+  return key;
+}
+
+// Unpacks a key made by packBoardKey
+template <int W, int H>
+Board<W, H> unpackBoardKey(uint64_t key) {
+  Board<W, H> board;
+  for (int i = 0; i < W * H; ++i) {
+    board.tiles[i] = (key >> (4 * i)) & packedCellMask;
+    if (board.tiles[i] == 0) board.blank = i;
+  }
+  return board;
+}
+
+// Slides the tile at newBlank into the blank of a board key
+uint64_t applyKeyMove(uint64_t key, int blank, int newBlank) {
+  uint64_t tile = (key >> (4 * newBlank)) & packedCellMask;
+  return (key & ~(packedCellMask << (4 * newBlank))) | (tile << (4 * blank));
+}
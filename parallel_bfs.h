@@ -0,0 +1,172 @@
+// Level-synchronous parallel breadth-first search over 8-puzzle boards: every
+// distance layer is split into chunks that the threads claim one at a time,
+// and children are deduplicated through a shared atomic bitmap indexed by
+// permutation rank.
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include "functions.h"
+#include "rank.h"
+#include "search_stats.h"
+
+using namespace std;
+
+const size_t bfsChunkSize = 1024;                                         // Layer states claimed by a thread at a time
+
+// Visited table shared by the threads, one atomic bit per rank (45 KB)
+class AtomicRankBitset {
+ public:
+  AtomicRankBitset() : words((stateCount + 63) / 64) {}
+
+  bool test(uint32_t rank) const { return (words[rank >> 6].load(memory_order_relaxed) >> (rank & 63)) & 1; }
+  bool insert(uint32_t rank) {                                            // True only for the one thread that set rank
+    uint64_t bit = uint64_t(1) << (rank & 63);
+    atomic<uint64_t> &word = words[rank >> 6];
+    if (word.load(memory_order_relaxed) & bit) return false;              // Skip the read-modify-write for known states
+    return !(word.fetch_or(bit, memory_order_relaxed) & bit);
+  }
+  size_t bytes() const { return words.capacity() * sizeof(uint64_t); }    // Heap memory held
+
+ private:
+  vector<atomic<uint64_t>> words;
+};
+
+/**
+ * @title Parallel Breadth-First Search
+ * @brief Expands the state space one distance layer at a time. The threads
+ * claim chunks of the current layer with an atomic counter and collect the
+ * children they are first to mark in the bitmap in their own buffers, which
+ * become the next layer once every thread is done. Only the thread that set
+ * a child's bit writes its parent entry, so the parent table needs no locks,
+ * and since every parent lies in the previous layer the recorded path is a
+ * shortest one. Which of several equally short paths is kept depends on the
+ * thread timing. Each object runs one search.
+ */
+class ParallelBfs {
+ public:
+  // Called with the distance and the states of every layer as it is completed
+  typedef function<void(int, const vector<PackedState> &)> LayerCallback;
+
+  explicit ParallelBfs(int threadCount) : threadCount(max(1, threadCount)) {}
+
+  // Searches from start until goal has been reached, or through the whole
+  // reachable space when stopAtGoal is false. Returns true if goal was reached.
+  bool run(PackedState start, PackedState goal, bool stopAtGoal, const LayerCallback &onLayer = nullptr) {
+    startStats();
+    vector<PackedState> layer(1, start);
+    visited.insert(rankPacked(start));
+    goalFound = start == goal;
+    vector<Worker> workers(threadCount);
+
+    for (int depth = 0; !layer.empty(); ++depth) {
+      layers.push_back(layer.size());
+      if (onLayer) onLayer(depth, layer);
+      if (goalFound && stopAtGoal) break;
+      peakStat(searchStats.peakFrontier, layer.size());
+      chargeTime(searchStats.bookkeepingSeconds);
+
+      expandLayer(layer, goal, workers);
+      chargeTime(searchStats.expansionSeconds);
+
+      layer.clear();
+      for (Worker &worker : workers) {
+        layer.insert(layer.end(), worker.next.begin(), worker.next.end());
+        worker.next.clear();
+      }
+    }
+
+    size_t bufferBytes = 0;
+    for (Worker &worker : workers) {
+      countStat(searchStats.nodesExpanded, worker.stats.nodesExpanded);
+      countStat(searchStats.nodesGenerated, worker.stats.nodesGenerated);
+      countStat(searchStats.duplicateHits, worker.stats.duplicateHits);
+      bufferBytes += worker.next.capacity() * sizeof(PackedState);
+    }
+    uint64_t reached = 0;
+    for (uint64_t size : layers) reached += size;
+    peakStat(searchStats.peakVisited, reached);
+    peakStat(searchStats.bytesAllocated, bufferBytes + layer.capacity() * sizeof(PackedState) + visited.bytes() + cameFrom.bytes());
+    chargeTime(searchStats.bookkeepingSeconds);
+    return goalFound;
+  }
+
+  const vector<uint64_t> &layerSizes() const { return layers; }           // Number of states at each distance
+  const RankParents &parents() const { return cameFrom; }
+
+ private:
+  struct Worker {
+    vector<PackedState> next;                                             // Children this thread was first to reach
+    SearchStats stats;
+  };
+
+  int threadCount;
+  AtomicRankBitset visited;
+  RankParents cameFrom;                                                   // Parent blank index of every reached state
+  vector<uint64_t> layers;
+  atomic<bool> goalFound{false};
+
+  // Expands every state of layer across the threads, the calling thread
+  // being one of them
+  void expandLayer(const vector<PackedState> &layer, PackedState goal, vector<Worker> &workers) {
+    atomic<size_t> nextChunk{0};
+    auto work = [&](Worker &worker) {
+      PackedState children[4];
+      for (size_t begin = nextChunk.fetch_add(bfsChunkSize); begin < layer.size(); begin = nextChunk.fetch_add(bfsChunkSize)) {
+        size_t end = min(layer.size(), begin + bfsChunkSize);
+        for (size_t i = begin; i < end; ++i) {
+          PackedState state = layer[i];
+          int childCount = getPackedMoves(state, children);
+          countStat(worker.stats.nodesExpanded);
+          countStat(worker.stats.nodesGenerated, childCount);
+          for (int c = 0; c < childCount; ++c) {
+            uint32_t childRank = rankPacked(children[c]);
+            if (!visited.insert(childRank)) {
+              countStat(worker.stats.duplicateHits);
+              continue;
+            }
+            cameFrom.set(childRank, state.blankIndex());
+            worker.next.push_back(children[c]);
+            if (children[c] == goal) goalFound.store(true, memory_order_relaxed);
+          }
+        }
+      }
+    };
+
+    // Small layers are not worth waking threads for
+    int helpers = int(min<size_t>(threadCount, (layer.size() + bfsChunkSize - 1) / bfsChunkSize)) - 1;
+    vector<thread> threads;
+    for (int t = 1; t <= helpers; ++t) threads.emplace_back(work, ref(workers[t]));
+    work(workers[0]);
+    for (thread &helper : threads) helper.join();
+  }
+};
+
+// Solves a board with the parallel breadth-first search on threadCount
+// threads, its moves are as few as breadthFirstSearch's
+bool parallelBreadthFirstSearch(const State &initialState, int threadCount, MoveSequence &moves) {
+  PackedState initial = packState(initialState);
+  ParallelBfs search(threadCount);
+  moves.clear();
+  if (!search.run(initial, packedGoal, true)) return false;               // Unsolvable, every reachable state was seen
+  moves = reconstructMoves(search.parents(), initial, packedGoal);
+  return true;
+}
+
+// Parallel breadth-first search, path of states from the initial state to the goal
+vector<State> parallelBreadthFirstSearch(const State &initialState, int threadCount) {
+  MoveSequence moves;
+  if (!parallelBreadthFirstSearch(initialState, threadCount, moves)) return vector<State>();
+  return replayMoves(initialState, moves);
+}
+
+// Counts the states at every distance from start, e.g. for analytics over the
+// whole state space, which ends at the last non-empty layer
+vector<uint64_t> parallelLayerSizes(PackedState start, int threadCount) {
+  ParallelBfs search(threadCount);
+  search.run(start, start, false);
+  return search.layerSizes();
+}
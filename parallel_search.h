@@ -0,0 +1,309 @@
+// Hash-distributed parallel A* (HDA*): every worker thread owns the boards
+// whose hash falls in its slice, keeps its own open and closed lists, and
+// sends the children it generates to their owners through lock-free queues.
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "functions.h"
+#include "open_list.h"
+#include "puzzle_search.h"
+#include "search_stats.h"
+
+using namespace std;
+
+// -------------- Messages --------------
+// A board generated by one worker for the worker that owns it
+struct HdaMessage {
+  uint64_t key;                                                           // Packed board (packBoardKey)
+  uint64_t parentKey;                                                     // 0 for the initial board
+  int g, h;                                                               // h is -1 when the owner has to compute it
+};
+
+const int hdaBatchSize = 64;                                              // Messages sent together to one worker
+const int hdaFlushInterval = 64;                                          // Expansions between flushes of partial batches
+const int hdaNoIncumbent = 1 << 30;                                       // Incumbent cost before any goal is found
+
+struct HdaBatch {
+  HdaBatch *next;
+  int count;
+  HdaMessage messages[hdaBatchSize];
+};
+
+/**
+ * @title Message Inbox
+ * @brief Lock-free multi-producer single-consumer queue of message batches.
+ * Producers push a batch with a compare-and-swap on the head, and the owner
+ * takes every batch at once with an exchange. Since the consumer never pops
+ * a single batch, a head can never be recycled under a producer (no ABA).
+ */
+class alignas(64) HdaInbox {                                              // Own cache line, producers hammer the head
+ public:
+  ~HdaInbox() {
+    for (HdaBatch *batch = takeAll(); batch != nullptr;) {
+      HdaBatch *next = batch->next;
+      delete batch;
+      batch = next;
+    }
+  }
+
+  void push(HdaBatch *batch) {
+    batch->next = head.load(memory_order_relaxed);
+    while (!head.compare_exchange_weak(batch->next, batch, memory_order_release, memory_order_relaxed)) {
+    }
+  }
+
+  HdaBatch *takeAll() { return head.exchange(nullptr, memory_order_acquire); }
+  bool empty() const { return head.load(memory_order_acquire) == nullptr; }
+
+ private:
+  atomic<HdaBatch *> head{nullptr};
+};
+
+// Worker owning a board, taken from the high hash bits so that the keys of
+// one worker still spread over its own hash table, which uses the low bits
+inline int hdaOwner(uint64_t key, int workerCount) {
+  return int((uint64_t(uint32_t(hashPacked(key) >> 32)) * uint64_t(workerCount)) >> 32);
+}
+
+/**
+ * @title Hash-Distributed A* Search
+ * @brief Parallel A* over W x H boards of up to 16 cells. Each worker expands
+ * its best open board while its f is below the incumbent (the cheapest goal
+ * found so far), so nothing that could lead to a cheaper solution is ever
+ * dropped. The search ends when every worker is out of such boards and no
+ * message is in flight, tracked by a single counter of busy workers plus
+ * undelivered messages: it only reaches zero once both are gone, and nothing
+ * can raise it again from there. With an admissible heuristic (1, 2 or 4) the
+ * incumbent is then optimal. Paths are rebuilt from the parent keys stored in
+ * the owners' closed lists once the workers have stopped.
+ */
+template <int W, int H, typename Heuristic>
+class HdaSearch {
+ public:
+  HdaSearch(const Heuristic &heuristic, int threadCount)
+      : heuristic(heuristic), workerCount(max(1, threadCount)), workers(workerCount) {}
+
+  bool run(const Board<W, H> &board, vector<int> &blankPath) {
+    blankPath.clear();
+    startStats();
+    if (!isBoardSolvable(board)) return false;
+
+    uint64_t startKey = packBoardKey(board);
+    goalKey = packBoardKey(goalBoard<W, H>());
+    incumbent.store(hdaNoIncumbent);
+    activity.store(workerCount);                                          // Every worker starts busy
+    Worker &owner = workers[hdaOwner(startKey, workerCount)];
+    receive(owner, {startKey, 0, 0, heuristic(board)});
+
+    vector<thread> threads;
+    for (int i = 0; i < workerCount; ++i) threads.emplace_back([this, i] { work(i); });
+    for (thread &worker : threads) worker.join();
+
+    collectStats();
+    if (incumbent.load() == hdaNoIncumbent) return false;
+    for (uint64_t key = goalKey; key != startKey;) {                      // Walk the parent keys back to the start
+      Worker &owner = workers[hdaOwner(key, workerCount)];
+      int index = *owner.bestNode.find(PackedState(key));
+      blankPath.push_back(owner.nodes[index].blank);
+      key = owner.parentKeys[index];
+    }
+    reverse(blankPath.begin(), blankPath.end());
+    return true;
+  }
+
+ private:
+  struct Worker {
+    vector<GenericNode> nodes;                                            // Node pool, parent field unused
+    vector<uint64_t> parentKeys;                                          // Parent board of each node
+    BucketQueue open;
+    PackedHashMap<int> bestNode;                                          // Cheapest node of each owned board
+    HdaInbox inbox;
+    vector<HdaBatch *> outbox;                                            // Partial batch for each worker
+    SearchStats stats;
+  };
+
+  Heuristic heuristic;                                                    // Shared by the workers, read only
+  int workerCount;
+  vector<Worker> workers;
+  uint64_t goalKey = 0;
+  atomic<int> incumbent{hdaNoIncumbent};                                  // Cost of the cheapest goal found so far
+  atomic<int64_t> activity{0};                                            // Busy workers plus messages in flight
+
+  // Adds a board to its owner's lists unless it is no improvement. Boards
+  // that cannot beat the incumbent are still recorded, nextNode skips them.
+  void receive(Worker &worker, const HdaMessage &message) {
+    bool inserted;
+    int &known = worker.bestNode.insert(PackedState(message.key), int(worker.nodes.size()), inserted);
+    int h = message.h;
+    if (!inserted) {
+      if (worker.nodes[known].g <= message.g) {                           // Not an improvement over the known path
+        countStat(worker.stats.duplicateHits);
+        return;
+      }
+      h = worker.nodes[known].h;                                          // Reopen the board, its h is unchanged
+      known = int(worker.nodes.size());
+    } else if (h < 0) {
+      h = heuristic(unpackBoardKey<W, H>(message.key));
+    }
+    int blank = 0;
+    while ((message.key >> (4 * blank) & packedCellMask) != 0) ++blank;
+    worker.open.push({message.g + h, message.g, int(worker.nodes.size())});
+    worker.nodes.push_back({message.key, blank, -1, message.g, h});
+    worker.parentKeys.push_back(message.parentKey);
+    peakStat(worker.stats.peakFrontier, worker.open.size());
+  }
+
+  // Hands a board to its owner, directly if that is this worker
+  void send(int self, const HdaMessage &message) {
+    int target = hdaOwner(message.key, workerCount);
+    if (target == self) {
+      receive(workers[self], message);
+      return;
+    }
+    HdaBatch *&batch = workers[self].outbox[target];
+    if (batch == nullptr) {
+      batch = new HdaBatch();
+      batch->count = 0;
+    }
+    batch->messages[batch->count++] = message;
+    if (batch->count == hdaBatchSize) flush(self, target);
+  }
+
+  void flush(int self, int target) {
+    HdaBatch *&batch = workers[self].outbox[target];
+    if (batch == nullptr) return;
+    activity.fetch_add(batch->count, memory_order_relaxed);               // Counted before it can be received
+    workers[target].inbox.push(batch);
+    batch = nullptr;
+  }
+
+  void flushAll(int self) {
+    for (int target = 0; target < workerCount; ++target) flush(self, target);
+  }
+
+  // Moves every delivered message into the open list
+  void drainInbox(Worker &worker) {
+    for (HdaBatch *batch = worker.inbox.takeAll(); batch != nullptr;) {
+      for (int i = 0; i < batch->count; ++i) receive(worker, batch->messages[i]);
+      activity.fetch_sub(batch->count, memory_order_acq_rel);             // This worker is busy, so the total stays positive
+      HdaBatch *next = batch->next;
+      delete batch;
+      batch = next;
+    }
+  }
+
+  // Pops the best open node worth expanding, -1 if there is none
+  int nextNode(Worker &worker) {
+    while (!worker.open.empty()) {
+      OpenEntry entry = worker.open.top();
+      if (entry.f >= incumbent.load(memory_order_relaxed)) return -1;     // Everything left is at least as costly
+      worker.open.pop();
+      if (*worker.bestNode.find(PackedState(worker.nodes[entry.node].key)) == entry.node) return entry.node;
+      countStat(worker.stats.duplicateHits);                              // A cheaper path to this board was found later
+    }
+    return -1;
+  }
+
+  void work(int self) {
+    Worker &worker = workers[self];
+    worker.outbox.assign(workerCount, nullptr);
+    const PuzzleTables<W, H> &tables = puzzleTables<W, H>;
+    int sinceFlush = 0;
+
+    while (true) {
+      drainInbox(worker);
+      int current = nextNode(worker);
+      if (current < 0) {                                                  // Idle: hand out what is buffered and wait
+        flushAll(self);
+        sinceFlush = 0;
+        if (activity.fetch_sub(1, memory_order_acq_rel) == 1) return;    // Nobody busy and nothing in flight
+        while (worker.inbox.empty()) {
+          if (activity.load(memory_order_acquire) == 0) return;
+          this_thread::yield();
+        }
+        activity.fetch_add(1, memory_order_acq_rel);                      // Still counted by the waiting messages
+        continue;
+      }
+
+      GenericNode node = worker.nodes[current];
+      if (node.key == goalKey) {                                          // A cheaper goal, lower the incumbent
+        int best = incumbent.load();
+        while (node.g < best && !incumbent.compare_exchange_weak(best, node.g)) {
+        }
+        continue;
+      }
+
+      countStat(worker.stats.nodesExpanded);
+      uint64_t parentKey = worker.parentKeys[current];
+      for (int d = 0; d < 4; ++d) {
+        int newBlank = tables.neighbors[node.blank][d];
+        if (newBlank < 0) continue;
+        uint64_t tile = (node.key >> (4 * newBlank)) & packedCellMask;
+        uint64_t childKey = (node.key & ~(packedCellMask << (4 * newBlank))) | (tile << (4 * node.blank));
+        if (childKey == parentKey) continue;                              // Undoing the last move never helps
+        countStat(worker.stats.nodesGenerated);
+        int childH = -1;                                                  // Left to the owner unless it is incremental
+        if constexpr (Heuristic::incremental) childH = heuristic.afterMove(node.h, tile, newBlank, node.blank, childKey);
+        if (childH >= 0 && node.g + 1 + childH >= incumbent.load(memory_order_relaxed)) continue;
+        send(self, {childKey, node.key, node.g + 1, childH});
+      }
+      if (++sinceFlush == hdaFlushInterval) {                             // Keep other workers fed
+        flushAll(self);
+        sinceFlush = 0;
+      }
+    }
+  }
+
+  void collectStats() {                                                   // Sums the workers' counters into searchStats
+    for (Worker &worker : workers) {
+      countStat(searchStats.nodesExpanded, worker.stats.nodesExpanded);
+      countStat(searchStats.nodesGenerated, worker.stats.nodesGenerated);
+      countStat(searchStats.duplicateHits, worker.stats.duplicateHits);
+      countStat(searchStats.peakFrontier, worker.stats.peakFrontier);
+      countStat(searchStats.peakVisited, worker.bestNode.size());
+      countStat(searchStats.bytesAllocated, worker.nodes.capacity() * sizeof(GenericNode) +
+                                                worker.parentKeys.capacity() * sizeof(uint64_t) + worker.bestNode.bytes() +
+                                                worker.stats.peakFrontier * sizeof(OpenEntry));
+    }
+  }
+};
+
+// Solves board with HDA* on threadCount workers (at least 1), filling
+// blankPath with the blank index after each move
+template <int W, int H>
+bool parallelAStar(const Board<W, H> &board, int heuristicType, int threadCount, vector<int> &blankPath) {
+  static_assert(W * H <= 16, "HDA* keys hold at most 16 cells");
+  return withBoardHeuristic<W, H>(heuristicType, [&](const auto &heuristic) { // Tables built before the workers start
+    HdaSearch<W, H, decay_t<decltype(heuristic)>> search(heuristic, threadCount);
+    return search.run(board, blankPath);
+  });
+}
+
+/**
+ * @title Parallel Best-First Search Algorithm
+ * @brief Runs HDA* on the 8-puzzle with the same heuristics as
+ * bestFirstSearch (cTilesOutOfPlace, cManDist, cHeuristicH, cPatternDb,
+ * through their board versions) and replays the blank moves into states.
+ *
+ * @param initialState The initial state of the 8-puzzle game.
+ * @param heuristicType The heuristic to use, as numbered in the menu.
+ * @param threadCount Number of worker threads.
+ * @return The path from the initial state to the goal state, optimal with the
+ * admissible heuristics 1, 2 and 4.
+ */
+vector<State> parallelBestFirstSearch(const State &initialState, int heuristicType, int threadCount) {
+  vector<int> blankPath;
+  if (!parallelAStar(makeBoard<3, 3>(initialState.board), heuristicType, threadCount, blankPath)) return vector<State>();
+  return replayBlankPath(initialState, blankPath);
+}
+
+// HDA* on an 8-puzzle, moves from the initial state to the goal
+bool parallelBestFirstSearch(const State &initialState, int heuristicType, int threadCount, MoveSequence &moves) {
+  vector<int> blankPath;
+  bool found = parallelAStar(makeBoard<3, 3>(initialState.board), heuristicType, threadCount, blankPath);
+  moves = MoveSequence::fromBlankPath<3, 3>(findBlankIndex(initialState), blankPath);
+  return found;
+}
@@ -0,0 +1,317 @@
+// Additive pattern databases: for disjoint groups of tiles, the exact number
+// of moves of the group's own tiles needed to bring them home, built by a
+// retrograde search over abstracted boards and stored in a versioned file.
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "puzzle.h"
+
+using namespace std;
+
+// -------------- File Layout --------------
+// A PatternDbHeader, then for each pattern a PatternDbSection followed by
+// entryCount one-byte distances (padded to 8 bytes), indexed by the partial
+// permutation rank of the pattern tiles' cells.
+const char pdbMagic[4] = {'S', 'P', 'D', 'B'};                            // File signature
+const uint32_t pdbVersion = 1;                                            // Bumped whenever the layout changes
+const uint8_t pdbUnreached = 0xFF;                                        // Abstract state not reached during the build
+
+struct PatternDbHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t width, height;
+  uint32_t patternCount;
+  uint32_t reserved;
+};
+
+struct PatternDbSection {
+  uint32_t tileMask;                                                      // Bit t set for every tile t in the pattern
+  uint32_t tileCount;
+  uint64_t entryCount;
+};
+
+string patternDatabasePath;                                               // File loaded by defaultPatternDatabase, empty to build in memory
+
+// Number of ordered placements of k tiles on n cells, n! / (n - k)!
+uint64_t placementCount(int cells, int tiles) {
+  uint64_t count = 1;
+  for (int i = 0; i < tiles; ++i) count *= cells - i;
+  return count;
+}
+
+// Default partition into disjoint groups of consecutive goal tiles (neighbors on the spiral)
+template <int W, int H>
+vector<uint32_t> defaultPartition() {
+  const int cells = W * H;
+  const int groupSize = cells <= 9 ? 4 : cells <= 16 ? 6 : 4;             // 4-4, 6-6-3, or six groups of 4
+  vector<uint32_t> partition;
+  for (int first = 1; first < cells; first += groupSize) {
+    uint32_t mask = 0;
+    for (int tile = first; tile < min(first + groupSize, cells); ++tile) mask |= 1u << tile;
+    partition.push_back(mask);
+  }
+  return partition;
+}
+
+/**
+ * @title Pattern Database
+ * @brief Additive pattern database heuristic over a disjoint partition of the
+ * tiles. Each pattern's table is built by a 0-1 breadth-first search from the
+ * goal over boards where only the pattern tiles and the blank are told apart:
+ * moving a pattern tile costs 1 and moving any other tile costs 0, so tables
+ * of disjoint patterns add up to an admissible estimate that dominates the
+ * Manhattan distance. Tables are built in memory or memory-mapped from a file.
+ */
+template <int W, int H>
+class PatternDatabase {
+ public:
+  static constexpr int cells = W * H;
+
+  PatternDatabase() {}
+  PatternDatabase(const PatternDatabase &) = delete;
+  PatternDatabase &operator=(const PatternDatabase &) = delete;
+  ~PatternDatabase() { close(); }
+
+  bool isLoaded() const { return !patterns.empty(); }
+  size_t patternCount() const { return patterns.size(); }
+
+  void build(const vector<uint32_t> &partition) {                         // Builds one table per tile group
+    close();
+    owned.resize(partition.size());
+    for (size_t p = 0; p < partition.size(); ++p) {
+      Pattern pattern = makePattern(partition[p]);
+      buildTable(pattern, owned[p]);
+      pattern.table = owned[p].data();
+      patterns.push_back(pattern);
+    }
+  }
+
+  bool save(const string &path) const {                                   // Writes the tables, false on I/O errors
+    ofstream out(path, ios::binary | ios::trunc);
+    if (!out) return false;
+    PatternDbHeader header;
+    memcpy(header.magic, pdbMagic, sizeof(pdbMagic));
+    header.version = pdbVersion;
+    header.width = W;
+    header.height = H;
+    header.patternCount = patterns.size();
+    header.reserved = 0;
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    for (const Pattern &pattern : patterns) {
+      PatternDbSection section = {pattern.mask, uint32_t(pattern.tileCount), pattern.entryCount};
+      out.write(reinterpret_cast<const char *>(&section), sizeof(section));
+      out.write(reinterpret_cast<const char *>(pattern.table), pattern.entryCount);
+      static const char padding[8] = {};
+      out.write(padding, paddedSize(pattern.entryCount) - pattern.entryCount);
+    }
+    return bool(out);
+  }
+
+  bool open(const string &path) {                                         // Maps a file written by save, false if missing or invalid
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || size_t(info.st_size) < sizeof(PatternDbHeader)) {
+      ::close(fd);
+      return false;
+    }
+    void *data = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);                                                          // The mapping stays valid after closing
+    if (data == MAP_FAILED) return false;
+    mapping = data;
+    mappingSize = info.st_size;
+
+    const char *bytes = static_cast<const char *>(data);
+    const PatternDbHeader *header = reinterpret_cast<const PatternDbHeader *>(bytes);
+    bool valid = memcmp(header->magic, pdbMagic, sizeof(pdbMagic)) == 0 && header->version == pdbVersion &&
+                 header->width == uint32_t(W) && header->height == uint32_t(H);
+    size_t offset = sizeof(PatternDbHeader);
+    uint32_t covered = 0;
+    for (uint32_t p = 0; valid && p < header->patternCount; ++p) {
+      if (offset + sizeof(PatternDbSection) > mappingSize) {
+        valid = false;
+        break;
+      }
+      const PatternDbSection *section = reinterpret_cast<const PatternDbSection *>(bytes + offset);
+      offset += sizeof(PatternDbSection);
+      Pattern pattern = makePattern(section->tileMask);
+      if ((section->tileMask & covered) || (section->tileMask & 1) || section->entryCount != pattern.entryCount ||
+          offset + paddedSize(pattern.entryCount) > mappingSize) {
+        valid = false;                                                    // Overlapping groups would not be admissible
+        break;
+      }
+      covered |= section->tileMask;
+      pattern.table = reinterpret_cast<const uint8_t *>(bytes + offset);
+      offset += paddedSize(pattern.entryCount);
+      patterns.push_back(pattern);
+    }
+    if (!valid || patterns.empty()) {
+      close();
+      return false;
+    }
+    return true;
+  }
+
+  void close() {
+    if (mapping != nullptr) munmap(mapping, mappingSize);
+    mapping = nullptr;
+    mappingSize = 0;
+    patterns.clear();
+    owned.clear();
+  }
+
+  int evaluate(const Board<W, H> &board) const {                          // Sum of every pattern's distance
+    int cellOf[cells];
+    for (int i = 0; i < cells; ++i) cellOf[board.tiles[i]] = i;
+    int total = 0;
+    for (const Pattern &pattern : patterns) {
+      int positions[cells];
+      for (int j = 0; j < pattern.tileCount; ++j) positions[j] = cellOf[pattern.tiles[j]];
+      total += pattern.table[rankPlacement(positions, pattern.tileCount)];
+    }
+    return total;
+  }
+
+ private:
+  struct Pattern {
+    uint32_t mask;
+    int tileCount;
+    int tiles[cells];                                                     // Pattern tiles in increasing order
+    uint64_t entryCount;
+    const uint8_t *table;
+  };
+
+  vector<Pattern> patterns;
+  vector<vector<uint8_t>> owned;                                          // Tables built in memory
+  void *mapping = nullptr;
+  size_t mappingSize = 0;
+
+  static size_t paddedSize(uint64_t size) { return (size + 7) & ~uint64_t(7); }
+
+  static Pattern makePattern(uint32_t mask) {
+    Pattern pattern;
+    pattern.mask = mask;
+    pattern.tileCount = 0;
+    for (int tile = 1; tile < cells; ++tile) {
+      if (mask >> tile & 1) pattern.tiles[pattern.tileCount++] = tile;
+    }
+    pattern.entryCount = placementCount(cells, pattern.tileCount);
+    pattern.table = nullptr;
+    return pattern;
+  }
+
+  // Rank of distinct cells positions[0..k) among all ordered placements
+  static uint64_t rankPlacement(const int *positions, int k) {
+    uint64_t rank = 0;
+    uint32_t used = 0;
+    for (int j = 0; j < k; ++j) {
+      int digit = positions[j] - __builtin_popcount(used & ((1u << positions[j]) - 1));
+      rank = rank * (cells - j) + digit;
+      used |= 1u << positions[j];
+    }
+    return rank;
+  }
+
+  // Inverse of rankPlacement
+  static void unrankPlacement(uint64_t rank, int k, int *positions) {
+    int digits[cells];
+    for (int j = k - 1; j >= 0; --j) {
+      digits[j] = rank % (cells - j);
+      rank /= cells - j;
+    }
+    uint32_t used = 0;
+    for (int j = 0; j < k; ++j) {
+      uint32_t candidates = ~used & ((1u << cells) - 1);
+      for (int skip = 0; skip < digits[j]; ++skip) candidates &= candidates - 1;
+      positions[j] = __builtin_ctz(candidates);
+      used |= 1u << positions[j];
+    }
+  }
+
+  // 0-1 breadth-first search from the goal over (pattern placement, blank cell)
+  static void buildTable(const Pattern &pattern, vector<uint8_t> &table) {
+    const PuzzleTables<W, H> &tables = puzzleTables<W, H>;
+    const int k = pattern.tileCount;
+    vector<uint8_t> distance(pattern.entryCount * cells, pdbUnreached);
+    deque<uint64_t> queue;                                                // Abstract states as placement * cells + blank
+
+    int positions[cells];
+    for (int j = 0; j < k; ++j) positions[j] = tables.goalIndex[pattern.tiles[j]];
+    uint64_t start = rankPlacement(positions, k) * cells + tables.blankGoal;
+    distance[start] = 0;
+    queue.push_back(start);
+
+    while (!queue.empty()) {
+      uint64_t state = queue.front();
+      queue.pop_front();
+      uint64_t placement = state / cells;
+      int blank = state % cells;
+      int cost = distance[state];
+      unrankPlacement(placement, k, positions);
+
+      for (int d = 0; d < 4; ++d) {
+        int newBlank = tables.neighbors[blank][d];
+        if (newBlank < 0) continue;
+        int moved = -1;                                                   // Pattern tile slid into the blank, if any
+        for (int j = 0; j < k; ++j) {
+          if (positions[j] == newBlank) moved = j;
+        }
+        uint64_t next;
+        int nextCost = cost;
+        if (moved >= 0) {
+          positions[moved] = blank;
+          next = rankPlacement(positions, k) * cells + newBlank;
+          positions[moved] = newBlank;
+          ++nextCost;
+        } else {
+          next = placement * cells + newBlank;
+        }
+        if (distance[next] <= nextCost) continue;
+        distance[next] = nextCost;
+        if (moved >= 0) queue.push_back(next);                            // Costly moves go to the back,
+        else queue.push_front(next);                                      // free ones to the front
+      }
+    }
+
+    table.assign(pattern.entryCount, pdbUnreached);                       // Keep the cheapest blank cell per placement
+    for (uint64_t state = 0; state < distance.size(); ++state) {
+      table[state / cells] = min(table[state / cells], distance[state]);
+    }
+  }
+};
+
+// Database for heuristic 4: mapped from patternDatabasePath if it holds a
+// valid file for this board size, otherwise built from defaultPartition
+template <int W, int H>
+const PatternDatabase<W, H> &defaultPatternDatabase() {
+  static PatternDatabase<W, H> database;
+  static once_flag loaded;
+  call_once(loaded, [] {
+    if (patternDatabasePath.empty() || !database.open(patternDatabasePath)) database.build(defaultPartition<W, H>());
+  });
+  return database;
+}
+
+// Board size (3, 4 or 5) of a valid file written by save, 0 if the file is
+// missing, corrupt or for none of these sizes
+int patternDatabaseFileSize(const string &path) {
+  PatternDatabase<3, 3> small;
+  PatternDatabase<4, 4> medium;
+  PatternDatabase<5, 5> large;
+  if (small.open(path)) return 3;
+  if (medium.open(path)) return 4;
+  return large.open(path) ? 5 : 0;
+}
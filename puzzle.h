@@ -0,0 +1,176 @@
+// Board geometry and heuristics for any W x H sliding puzzle. Every table is
+// generated at compile time from the width and height, so the 3x3
+// instantiation compiles down to the same lookups as hand-written 8-puzzle
+// code while 4x4 (15-puzzle) and 5x5 (24-puzzle) boards share the engines.
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+using namespace std;
+
+// -------------- Compile-Time Tables --------------
+/**
+ * @title Puzzle Tables
+ * @brief Lookup tables for a W x H puzzle, built by a constexpr constructor.
+ * The goal is the clockwise spiral the 8-puzzle uses (1 2 3 / 8 0 4 / 7 6 5),
+ * numbered from the top-left corner inwards with the blank on the last cell,
+ * unless the tables are built at run time for another goal. The sequence
+ * score ring is the clockwise perimeter.
+ */
+template <int W, int H>
+struct PuzzleTables {
+  static constexpr int cells = W * H;
+  static constexpr int ringLength = 2 * (W + H) - 4;
+
+  int8_t neighbors[cells][4];                                             // Blank index after moving Up, Down, Left, Right, -1 if off the board
+  int goal[cells];                                                        // Tile on each cell of the goal
+  int goalIndex[cells];                                                   // Goal cell of each tile
+  int manhattan[cells][cells];                                            // Manhattan distance of tile t standing on cell i (0 for the blank)
+  int misplaced[cells][cells];                                            // 1 if tile t standing on cell i is out of place (0 for the blank)
+  int ring[ringLength];                                                   // Perimeter cells in clockwise order
+  int successor[cells];                                                   // Tile that follows tile t clockwise on the goal perimeter, -1 if t is inside
+  int blankGoal;                                                          // Goal cell of the blank
+
+  constexpr PuzzleTables()
+      : neighbors(), goal(), goalIndex(), manhattan(), misplaced(), ring(), successor(), blankGoal(0) {
+    int top = 0, bottom = H - 1, left = 0, right = W - 1, tile = 1;      // Walk the spiral, shrinking the bounds
+    while (top <= bottom && left <= right) {
+      for (int c = left; c <= right; ++c) goal[top * W + c] = tile++;
+      for (int r = top + 1; r <= bottom; ++r) goal[r * W + right] = tile++;
+      if (top < bottom)
+        for (int c = right - 1; c >= left; --c) goal[bottom * W + c] = tile++;
+      if (left < right)
+        for (int r = bottom - 1; r > top; --r) goal[r * W + left] = tile++;
+      ++top, --bottom, ++left, --right;
+    }
+    for (int i = 0; i < cells; ++i) {
+      if (goal[i] == cells) goal[i] = 0;                                  // The last spiral cell holds the blank
+    }
+    fill();
+  }
+
+  // Tables for another goal, a permutation of 0 to cells - 1 in row-major
+  // order, for the searches that solve against it directly
+  constexpr explicit PuzzleTables(const int *goalTiles)
+      : neighbors(), goal(), goalIndex(), manhattan(), misplaced(), ring(), successor(), blankGoal(0) {
+    for (int i = 0; i < cells; ++i) goal[i] = goalTiles[i];
+    fill();
+  }
+
+ private:
+  constexpr void fill() {                                                 // Every table but the goal itself
+    for (int i = 0; i < cells; ++i) {
+      int row = i / W, col = i % W;
+      neighbors[i][0] = row > 0 ? i - W : -1;
+      neighbors[i][1] = row < H - 1 ? i + W : -1;
+      neighbors[i][2] = col > 0 ? i - 1 : -1;
+      neighbors[i][3] = col < W - 1 ? i + 1 : -1;
+    }
+
+    for (int i = 0; i < cells; ++i) goalIndex[goal[i]] = i;
+    blankGoal = goalIndex[0];
+
+    for (int t = 0; t < cells; ++t) {
+      for (int i = 0; i < cells; ++i) {
+        int rowDistance = i / W - goalIndex[t] / W, colDistance = i % W - goalIndex[t] % W;
+        manhattan[t][i] = t == 0 ? 0 : (rowDistance < 0 ? -rowDistance : rowDistance) + (colDistance < 0 ? -colDistance : colDistance);
+        misplaced[t][i] = t != 0 && goalIndex[t] != i;
+      }
+    }
+
+    int k = 0;
+    for (int c = 0; c < W; ++c) ring[k++] = c;
+    for (int r = 1; r < H; ++r) ring[k++] = r * W + W - 1;
+    for (int c = W - 2; c >= 0; --c) ring[k++] = (H - 1) * W + c;
+    for (int r = H - 2; r > 0; --r) ring[k++] = r * W;
+    for (int t = 0; t < cells; ++t) successor[t] = -1;
+    for (int j = 0; j < ringLength; ++j) {
+      successor[goal[ring[j]]] = goal[ring[(j + 1) % ringLength]];
+    }
+  }
+};
+
+template <int W, int H>
+constexpr PuzzleTables<W, H> puzzleTables{};
+
+// -------------- Boards --------------
+template <int W, int H>
+struct Board {                                                            // A W x H board, 0 is the blank
+  static constexpr int cells = W * H;
+  uint8_t tiles[cells];
+  int blank;
+
+  bool operator==(const Board &other) const { return equal(tiles, tiles + cells, other.tiles); }
+};
+
+// Builds a board from tiles in row-major order
+template <int W, int H>
+Board<W, H> makeBoard(const int *tiles) {
+  Board<W, H> board;
+  for (int i = 0; i < W * H; ++i) {
+    board.tiles[i] = tiles[i];
+    if (tiles[i] == 0) board.blank = i;
+  }
+  return board;
+}
+
+// The goal board
+template <int W, int H>
+Board<W, H> goalBoard() {
+  return makeBoard<W, H>(puzzleTables<W, H>.goal);
+}
+
+// Total Manhattan distance of every tile to its goal cell, in the standard
+// goal unless the tables of another one are given
+template <int W, int H>
+int boardManhattan(const Board<W, H> &board, const PuzzleTables<W, H> &tables = puzzleTables<W, H>) {
+  int total = 0;
+  for (int i = 0; i < W * H; ++i) total += tables.manhattan[board.tiles[i]][i];
+  return total;
+}
+
+// Number of tiles out of place, the blank excluded
+template <int W, int H>
+int boardMisplaced(const Board<W, H> &board, const PuzzleTables<W, H> &tables = puzzleTables<W, H>) {
+  int total = 0;
+  for (int i = 0; i < W * H; ++i) total += tables.misplaced[board.tiles[i]][i];
+  return total;
+}
+
+// Sequence score: 1 if the blank's goal cell holds a tile, plus 2 for every
+// perimeter tile not followed clockwise by its goal successor
+template <int W, int H>
+int boardSequenceScore(const Board<W, H> &board) {
+  const PuzzleTables<W, H> &tables = puzzleTables<W, H>;
+  int score = board.tiles[tables.blankGoal] != 0;
+  for (int j = 0; j < tables.ringLength; ++j) {
+    int tile = board.tiles[tables.ring[j]];
+    if (tile == 0) continue;                                              // Skip the blank tile
+    int next = board.tiles[tables.ring[(j + 1) % tables.ringLength]];
+    if (next != tables.successor[tile]) score += 2;
+  }
+  return score;
+}
+
+/**
+ * @title Board Solvability Checker
+ * @brief A board is solvable exactly when the parity of the permutation that
+ * takes it to the goal (blank included) equals the parity of the blank's
+ * Manhattan distance to its goal cell, since every move swaps the blank with
+ * a neighbor. This covers even widths, where inversions alone do not decide.
+ */
+template <int W, int H>
+bool isBoardSolvable(const Board<W, H> &board) {
+  const PuzzleTables<W, H> &tables = puzzleTables<W, H>;
+  int inversions = 0;
+  for (int i = 0; i < W * H; ++i) {
+    for (int j = i + 1; j < W * H; ++j) {
+      inversions += tables.goalIndex[board.tiles[i]] > tables.goalIndex[board.tiles[j]];
+    }
+  }
+  int blankDistance = abs(board.blank / W - tables.blankGoal / W) + abs(board.blank % W - tables.blankGoal % W);
+  return inversions % 2 == blankDistance % 2;
+}
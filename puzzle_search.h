@@ -0,0 +1,164 @@
+// A* for W x H puzzles of up to 16 cells, keyed on boards packed 4 bits per
+// cell. Larger boards are left to IdaSearch, whose memory stays O(depth).
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "functions.h"
+#include "graph_search.h"
+#include "ida_search.h"
+#include "open_list.h"
+#include "puzzle.h"
+#include "search_stop.h"
+
+using namespace std;
+
+// Memory and time allowed to a search, whichever limit is reached first
+struct SearchBudget {
+  size_t bytes = SIZE_MAX;                                                // Heap memory held by the search's containers
+  size_t nodes = SIZE_MAX;                                                // Nodes stored in the node pool
+  SearchStop stop;                                                        // Deadline and cancellation, polled
+};
+
+// Heap memory the containers of an A* search may hold while it expands one
+// more board (up to 4 new nodes): a container that has to grow holds its old
+// buffer and the doubled one at once while the entries are copied over
+template <typename Node, typename OpenList>
+size_t expansionPeakBytes(const vector<Node> &nodes, const PackedHashMap<int> &bestNode, const OpenList &frontier) {
+  size_t nodeBytes = nodes.capacity() * sizeof(Node);
+  if (nodes.size() + 4 > nodes.capacity()) nodeBytes *= 3;
+  return nodeBytes + bestNode.bytesAfterInserts(4) + frontier.bytes();
+}
+
+/**
+ * @title Budgeted Node Pool
+ * @brief NodePool that calls the search off before an expansion that could
+ * take it over budget, setting overBudgetBound to the f of the state it was
+ * about to expand, and once budget.stop is requested, which it polls every
+ * stopCheckInterval expansions.
+ */
+template <typename Encoding>
+class BudgetedNodePool : public NodePool<Encoding> {
+ public:
+  BudgetedNodePool(vector<typename Encoding::Node> &nodes, PackedHashMap<int> &bestNode, const SearchBudget &budget,
+                   int &overBudgetBound)
+      : NodePool<Encoding>(nodes, bestNode), budget(budget), overBudgetBound(overBudgetBound) {}
+
+  template <typename Frontier>
+  bool canExpand(const Frontier &frontier) {
+    if (this->nodes.size() + 4 > budget.nodes || expansionPeakBytes(this->nodes, this->bestNode, frontier) > budget.bytes) {
+      overBudgetBound = this->nodes[this->current].g + this->nodes[this->current].h; // Popped first, so the lowest f left
+      return false;
+    }
+    if (++sinceCheck == stopCheckInterval) {
+      sinceCheck = 0;
+      if (budget.stop.requested()) return false;
+    }
+    return true;
+  }
+
+ private:
+  const SearchBudget &budget;
+  int &overBudgetBound;
+  int sinceCheck = 0;                                                     // Expansions since the last poll
+};
+
+// A* within budget with the heuristic functor already picked, see below
+template <int W, int H, typename OpenList, typename Heuristic>
+bool aStarWithinBudget(const Board<W, H> &board, const Heuristic &heuristic, const SearchBudget &budget,
+                       vector<int> &blankPath, int &overBudgetBound) {
+  using Encoding = BoardEncoding<W, H>;
+  blankPath.clear();
+  overBudgetBound = -1;
+  if (!isBoardSolvable(board)) return false;
+
+  vector<GenericNode> nodes;                                              // Node pool
+  OpenList open;                                                          // Open list
+  PackedHashMap<int> bestNode;                                            // Cheapest node found so far for each board
+  OrderedFrontier<OpenList> frontier(open);
+  BudgetedNodePool<Encoding> visited(nodes, bestNode, budget, overBudgetBound);
+  MoveSequence moves;
+  if (!graphSearch<Encoding>(Encoding::encode(board), frontier, visited, heuristic, moves)) return false;
+  blankPath = moves.toBlankPath<W, H>(board.blank);
+  return true;
+}
+
+/**
+ * @title Generic A* Search
+ * @brief A* over packed W x H boards, the graphSearch loop of
+ * bestFirstSearch over BoardEncoding: a node pool with parent indices, g and
+ * h computed once per node (Manhattan distance and misplaced tiles from the
+ * moved tile's delta), an f-ordered open list (BucketQueue unless another
+ * OpenList is given) and a closed map that reopens states reached more
+ * cheaply.
+ *
+ * Before each expansion the search checks that it stays within budget. If
+ * the expansion could take it over, it gives up, frees everything and sets
+ * overBudgetBound to the f of the board it was about to expand: the lowest f
+ * left open, so no solution is shorter when the heuristic is admissible.
+ * Every stopCheckInterval expansions it also polls budget.stop, and gives
+ * up without a bound once a stop is requested.
+ *
+ * @param board The initial board.
+ * @param heuristicType The heuristic to use, as numbered in the menu, picked
+ * once before the search starts.
+ * @param budget The memory and time the search may use.
+ * @param blankPath Filled with the blank index after each move.
+ * @param overBudgetBound Set to -1, or to the bound reached when the search
+ * ran out of memory.
+ * @return true if a path was found.
+ */
+template <int W, int H, typename OpenList = BucketQueue>
+bool aStarWithinBudget(const Board<W, H> &board, int heuristicType, const SearchBudget &budget, vector<int> &blankPath,
+                       int &overBudgetBound) {
+  return withBoardHeuristic<W, H>(heuristicType, [&](const auto &heuristic) {
+    return aStarWithinBudget<W, H, OpenList>(board, heuristic, budget, blankPath, overBudgetBound);
+  });
+}
+
+// A* without a memory budget
+template <int W, int H, typename OpenList = BucketQueue>
+bool aStar(const Board<W, H> &board, int heuristicType, vector<int> &blankPath) {
+  int overBudgetBound;
+  return aStarWithinBudget<W, H, OpenList>(board, heuristicType, SearchBudget(), blankPath, overBudgetBound);
+}
+
+/**
+ * @title Memory-Bounded Search
+ * @brief Runs A* within budget and, should it run out, falls back to IDA*,
+ * whose memory is O(depth), starting from the bound A* had reached instead
+ * of from h. The answer is the same as A*'s; only the time to reach it
+ * grows on boards too hard for the budget. The statistics cover both phases.
+ *
+ * @param board The initial board.
+ * @param heuristicType The heuristic to use, as numbered in the menu.
+ * @param budget The memory the A* phase may use, and the stop of both phases.
+ * @param blankPath Filled with the blank index after each move.
+ * @return true if a path was found.
+ */
+template <int W, int H>
+bool boundedSearch(const Board<W, H> &board, int heuristicType, const SearchBudget &budget, vector<int> &blankPath) {
+  int overBudgetBound;
+  if (aStarWithinBudget(board, heuristicType, budget, blankPath, overBudgetBound)) return true;
+  if (overBudgetBound < 0) return false;                                  // Exhausted within budget, no solution
+
+  bool found = idaDeepen(board, heuristicType, &budget.stop, overBudgetBound, blankPath); // Continues the A* statistics
+  chargeTime(searchStats.bookkeepingSeconds);
+  return found;
+}
+
+// Solves an 8-puzzle with boundedSearch, path from the initial state to the goal
+vector<State> boundedBestFirstSearch(const State &initialState, int heuristicType, const SearchBudget &budget) {
+  vector<int> blankPath;
+  if (!boundedSearch(makeBoard<3, 3>(initialState.board), heuristicType, budget, blankPath)) return vector<State>();
+  return replayBlankPath(initialState, blankPath);
+}
+
+// Solves an 8-puzzle with boundedSearch, moves from the initial state to the goal
+bool boundedBestFirstSearch(const State &initialState, int heuristicType, const SearchBudget &budget, MoveSequence &moves) {
+  vector<int> blankPath;
+  bool found = boundedSearch(makeBoard<3, 3>(initialState.board), heuristicType, budget, blankPath);
+  moves = MoveSequence::fromBlankPath<3, 3>(findBlankIndex(initialState), blankPath);
+  return found;
+}
@@ -0,0 +1,96 @@
+// Permutation ranking (Lehmer code) of 8-puzzle boards and the flat tables
+// indexed by it.
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "packed.h"
+
+using namespace std;
+
+// -------------- Ranking Constants --------------
+const uint32_t stateCount = 362880;                                       // 9!, number of permutations of the board
+const uint8_t noParent = 0xFF;                                            // Parent entry of a state that has no parent
+const uint32_t factorials[9] = {40320, 5040, 720, 120, 24, 6, 2, 1, 1};   // (8 - i)! for each board position i
+
+/**
+ * @title Permutation Rank
+ * @brief Maps a packed board to its index in the factorial number system,
+ * a dense number in [0, 9!). Each digit is the number of still unused tiles
+ * smaller than the tile at that position, counted with a bit mask.
+ *
+ * @param state The packed board to rank.
+ * @return The rank of the board.
+ */
+uint32_t rankPacked(PackedState state) {
+  uint32_t rank = 0;
+  uint32_t seen = 0;                                                      // Bit t is set once tile t has been placed
+  for (int i = 0; i < 9; ++i) {
+    int tile = state.tileAt(i);
+    int smallerUnused = tile - __builtin_popcount(seen & ((1u << tile) - 1));
+    rank += smallerUnused * factorials[i];
+    seen |= 1u << tile;
+  }
+  return rank;
+}
+
+/**
+ * @title Permutation Unrank
+ * @brief Inverse of rankPacked, rebuilds the packed board with the given rank.
+ *
+ * @param rank The rank of the board, in [0, 9!).
+ * @return The packed board.
+ */
+PackedState unrankPacked(uint32_t rank) {
+  uint32_t unused = 0x1FF;                                                // Tiles 0-8 still available
+  uint64_t bits = 0;
+  int blank = 0;
+  for (int i = 0; i < 9; ++i) {
+    uint32_t digit = rank / factorials[i];
+    rank %= factorials[i];
+    uint32_t candidates = unused;
+    for (uint32_t k = 0; k < digit; ++k) candidates &= candidates - 1;    // Drop the digit smallest unused tiles
+    int tile = __builtin_ctz(candidates);
+    unused &= ~(1u << tile);
+    bits |= uint64_t(tile) << (4 * i);
+    if (tile == 0) blank = i;
+  }
+  bits |= uint64_t(blank) << packedBlankShift;
+  return PackedState(bits);
+}
+
+// Flat visited table with one bit per permutation rank (45 KB)
+class RankBitset {
+ public:
+  RankBitset() : words((stateCount + 63) / 64, 0) {}
+
+  bool test(uint32_t rank) const { return (words[rank >> 6] >> (rank & 63)) & 1; }
+  bool insert(uint32_t rank) {                                            // Returns true if rank was not yet set
+    uint64_t bit = uint64_t(1) << (rank & 63);
+    bool fresh = !(words[rank >> 6] & bit);
+    words[rank >> 6] |= bit;
+    return fresh;
+  }
+  void clear() { fill(words.begin(), words.end(), 0); }                   // One fixed-size 45 KB fill
+  size_t bytes() const { return words.capacity() * sizeof(uint64_t); }    // Heap memory held
+
+ private:
+  vector<uint64_t> words;
+};
+
+// Flat parent table, one byte per rank (354 KB). Instead of the parent's rank
+// it stores the parent's blank index: sliding the blank back there recovers
+// the parent, so a byte is enough.
+class RankParents {
+ public:
+  RankParents() : parents(stateCount, noParent) {}
+
+  void set(uint32_t rank, int parentBlank) { parents[rank] = parentBlank; }
+  uint8_t get(uint32_t rank) const { return parents[rank]; }
+  size_t bytes() const { return parents.capacity(); }                     // Heap memory held
+
+ private:
+  vector<uint8_t> parents;
+};
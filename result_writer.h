@@ -0,0 +1,199 @@
+// Buffered writer of batch results: the moves of every solved line, or the
+// boards along its path, as text lines or binary records, streamed through
+// one fixed buffer instead of a string per line or per tile.
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ostream>
+#include <string>
+
+#include "move_sequence.h"
+
+using namespace std;
+
+// -------------- Output Formats --------------
+enum OutputFormat { OUTPUT_TEXT, OUTPUT_BINARY };
+enum OutputContent { OUTPUT_MOVES, OUTPUT_BOARDS };                       // What follows the numbers of a solved line
+
+enum ResultStatus { RESULT_SOLVED, RESULT_UNSOLVABLE, RESULT_INVALID, RESULT_FAILED };
+const char *const resultStatusNames[] = {"solved", "unsolvable", "invalid", "failed"};
+
+// -------------- Binary Layout --------------
+// A ResultFileHeader, then one record per line in input order: the line
+// number (uint64_t), status (uint8_t), number of moves (int32_t, -1 unless
+// solved), microseconds (int64_t) and bound (double, 0 unless anytime). A
+// solved record goes on with its moves 4 to a byte, first move in the low
+// bits, or with every board along its path, one byte per cell. Numbers are in
+// host byte order.
+const char resultMagic[4] = {'8', 'P', 'R', 'S'};                         // File signature
+const uint32_t resultVersion = 1;                                         // Bumped whenever the layout changes
+
+struct ResultFileHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t width, height;
+  uint32_t content;                                                       // OUTPUT_MOVES or OUTPUT_BOARDS
+};
+
+// Outcome of one batch line
+struct BatchResult {
+  ResultStatus status = RESULT_INVALID;
+  int64_t micros = 0;
+  MoveSequence moves;                                                     // Only set on solved lines
+  uint8_t tiles[25];                                                      // Initial board, read by board output
+  double bound = 0;                                                       // Proven suboptimality bound, anytime lines only
+  string stats;                                                           // Search statistics as JSON, if asked for
+};
+
+/**
+ * @title Result Writer
+ * @brief Formats batch results straight into a 64 KB buffer that is handed to
+ * the stream whenever it fills up. Text lines are tab-separated: line number,
+ * status, number of moves, microseconds, then the move letters or the boards
+ * along the path (tiles separated by commas, boards by spaces), then the
+ * bound and statistics when present. Binary output is described above.
+ */
+class ResultWriter {
+ public:
+  ResultWriter(ostream &out, OutputFormat format, OutputContent content, int width, int height)
+      : out(out), format(format), content(content), width(width), cells(width * height) {
+    if (format == OUTPUT_BINARY) {
+      ResultFileHeader header;
+      memcpy(header.magic, resultMagic, sizeof(resultMagic));
+      header.version = resultVersion;
+      header.width = width;
+      header.height = height;
+      header.content = content;
+      putRaw(&header, sizeof(header));
+    }
+  }
+
+  ~ResultWriter() { flush(); }
+
+  void write(uint64_t lineNumber, const BatchResult &result) {
+    bool solved = result.status == RESULT_SOLVED;
+    int32_t length = solved ? int32_t(result.moves.size()) : -1;
+    if (format == OUTPUT_BINARY) {
+      uint8_t status = result.status;
+      putRaw(&lineNumber, sizeof(lineNumber));
+      putRaw(&status, sizeof(status));
+      putRaw(&length, sizeof(length));
+      putRaw(&result.micros, sizeof(result.micros));
+      putRaw(&result.bound, sizeof(result.bound));
+      if (solved) {
+        if (content == OUTPUT_MOVES) {
+          for (size_t b = 0; b < (result.moves.size() + 3) / 4; ++b) put(char(result.moves.packedByte(b)));
+        } else {
+          writeBoards(result);
+        }
+      }
+      return;
+    }
+
+    putNumber(lineNumber);
+    put('\t');
+    putString(resultStatusNames[result.status]);
+    put('\t');
+    if (length < 0) put('-');
+    putNumber(length < 0 ? 1 : length);
+    put('\t');
+    putNumber(result.micros);
+    put('\t');
+    if (solved) {
+      if (content == OUTPUT_MOVES) {
+        for (size_t i = 0; i < result.moves.size(); ++i) put(moveLetters[result.moves[i]]);
+      } else {
+        writeBoards(result);
+      }
+    }
+    if (result.bound > 0) {
+      char text[32];
+      snprintf(text, sizeof(text), "\t%g", result.bound);                 // Same digits as ostream's default
+      putString(text);
+    }
+    if (!result.stats.empty()) {
+      put('\t');
+      putString(result.stats.c_str());
+    }
+    put('\n');
+  }
+
+  void flush() {                                                          // Hands everything written so far to the stream
+    drain();
+    out.flush();
+  }
+
+ private:
+  static const size_t capacity = 1 << 16;
+  ostream &out;
+  OutputFormat format;
+  OutputContent content;
+  int width, cells;
+  char buffer[capacity];
+  size_t used = 0;
+
+  void drain() {
+    out.write(buffer, used);
+    used = 0;
+  }
+
+  char *reserve(size_t bytes) {                                           // Room for bytes more, at most capacity
+    if (used + bytes > capacity) drain();
+    return buffer + used;
+  }
+
+  void put(char c) {
+    *reserve(1) = c;
+    ++used;
+  }
+
+  void putRaw(const void *data, size_t bytes) {
+    memcpy(reserve(bytes), data, bytes);
+    used += bytes;
+  }
+
+  void putString(const char *text) {
+    while (*text != '\0') put(*text++);
+  }
+
+  void putNumber(uint64_t value) {
+    char digits[20];
+    int count = 0;
+    do {
+      digits[count++] = char('0' + value % 10);
+      value /= 10;
+    } while (value > 0);
+    char *at = reserve(count);
+    for (int i = 0; i < count; ++i) at[i] = digits[count - 1 - i];
+    used += count;
+  }
+
+  // Every board along the path, the initial one included, by sliding the
+  // blank of a local copy
+  void writeBoards(const BatchResult &result) {
+    const int offsets[4] = {-width, width, -1, 1};                        // Blank index change for Up, Down, Left, Right
+    uint8_t board[25];
+    memcpy(board, result.tiles, cells);
+    int blank = int(find(board, board + cells, 0) - board);
+    for (size_t step = 0; step <= result.moves.size(); ++step) {
+      if (step > 0) {
+        int next = blank + offsets[result.moves[step - 1]];
+        board[blank] = board[next];
+        board[next] = 0;
+        blank = next;
+      }
+      if (format == OUTPUT_BINARY) {
+        putRaw(board, cells);
+        continue;
+      }
+      if (step > 0) put(' ');
+      for (int i = 0; i < cells; ++i) {
+        if (i > 0) put(',');
+        putNumber(board[i]);
+      }
+    }
+  }
+};
@@ -0,0 +1,70 @@
+// Storage of the 8-puzzle searches, kept between solves so that repeated
+// searches on a thread (menu rounds, batch lines) reuse the memory of the
+// previous ones instead of allocating and faulting in fresh containers.
+#pragma once
+
+#include <vector>
+
+#include "open_list.h"
+#include "packed.h"
+#include "rank.h"
+
+using namespace std;
+
+// Node of the A* search tree, stored in a pool and linked to its parent by index
+struct SearchNode {
+  PackedState state;
+  int parent;                                                             // Index of the parent node, -1 for the root
+  int g, h, f;                                                            // Computed once when the node is created
+};
+
+// Node of the A* search tree over W x H board keys (packBoardKey)
+struct GenericNode {
+  uint64_t key;
+  int blank;
+  int parent;                                                             // Index of the parent node, -1 for the root
+  int g, h;
+};
+
+/**
+ * @title Search Context
+ * @brief Frontier, visited and node storage shared by depthFirstSearch,
+ * breadthFirstSearch, bidirectionalSearch and bestFirstSearch. Every search
+ * resets the context first, which empties the containers in O(1) without
+ * releasing their memory: vectors keep their capacity and the hash map and
+ * bucket queue start over. The searches that use a visited bitset clear it
+ * themselves (a fixed 45 KB fill), and the parent and depth tables are never
+ * cleared, since a search only reads them back for states it reached itself.
+ */
+class SearchContext {
+ public:
+  vector<PackedState> frontier;                                           // DFS stack, BFS queue, forward layer
+  vector<PackedState> backwardFrontier;                                   // Backward layer of the bidirectional search
+  vector<PackedState> nextLayer;                                          // Layer being built by expandLayer
+  RankBitset visited, backwardVisited;
+  RankParents parents, backwardParents;                                   // Parent blank index towards the start / the goal
+  vector<uint8_t> forwardDepth, backwardDepth;                            // Layer of every state reached from each side
+  vector<SearchNode> nodes;                                               // Node pool of best-first search
+  BucketQueue open;
+  PackedHashMap<int> bestNode;                                            // Cheapest node found so far for each state
+
+  void reset() {
+    frontier.clear();
+    backwardFrontier.clear();
+    nextLayer.clear();
+    nodes.clear();
+    open.clear();
+    bestNode.clear();
+  }
+
+  void useDepths() {                                                      // Allocates the depth tables on first use
+    if (forwardDepth.empty()) forwardDepth.assign(stateCount, 0);
+    if (backwardDepth.empty()) backwardDepth.assign(stateCount, 0);
+  }
+};
+
+// Context of the calling thread, created by its first search
+SearchContext &threadSearchContext() {
+  thread_local SearchContext context;
+  return context;
+}
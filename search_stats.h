@@ -0,0 +1,83 @@
+// Instrumentation filled by every search: how much work it did, how much
+// memory it held and, optionally, where its time went. SEARCH_STATS picks
+// what is compiled in: 0 nothing, 1 the counters (default), 2 the counters and
+// the per-phase timers.
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+#ifndef SEARCH_STATS
+#define SEARCH_STATS 1
+#endif
+
+constexpr int searchStatsLevel = SEARCH_STATS;
+
+/**
+ * @title Search Statistics
+ * @brief Effort of the last search run on a thread. Counters are plain
+ * additions, and the timers read the clock once per phase change, charging the
+ * time since the previous change to the phase that just ended. Every helper
+ * below compiles to nothing when its level is switched off.
+ */
+struct SearchStats {
+  uint64_t nodesExpanded = 0;                                             // States whose children were generated
+  uint64_t nodesGenerated = 0;                                            // Children produced by move generation
+  uint64_t duplicateHits = 0;                                             // States dropped because they were already reached as cheaply
+  uint64_t peakFrontier = 0;                                              // Largest open list (recursion depth for IDA*)
+  uint64_t peakVisited = 0;                                               // Largest set of reached states
+  uint64_t bytesAllocated = 0;                                            // Heap memory held by the search's containers at their largest
+  double heuristicSeconds = 0;
+  double expansionSeconds = 0;
+  double bookkeepingSeconds = 0;                                          // Open list, visited set and path handling
+  chrono::steady_clock::time_point lastCharge;
+
+  string toJson() const {
+    ostringstream out;
+    out << "{\"level\":" << searchStatsLevel << ",\"nodes_expanded\":" << nodesExpanded
+        << ",\"nodes_generated\":" << nodesGenerated << ",\"duplicate_hits\":" << duplicateHits
+        << ",\"peak_frontier\":" << peakFrontier << ",\"peak_visited\":" << peakVisited
+        << ",\"bytes_allocated\":" << bytesAllocated << ",\"heuristic_seconds\":" << heuristicSeconds
+        << ",\"expansion_seconds\":" << expansionSeconds << ",\"bookkeeping_seconds\":" << bookkeepingSeconds << "}";
+    return out.str();
+  }
+};
+
+thread_local SearchStats searchStats;                                     // Filled by the last search run on this thread
+
+// Clears the statistics at the start of a search
+inline void startStats() {
+  searchStats = SearchStats();
+  if constexpr (searchStatsLevel >= 2) searchStats.lastCharge = chrono::steady_clock::now();
+}
+
+// States the last search expanded, for display: "n/a" when the counters are
+// compiled out, rather than a count of 0
+inline string expandedNodes() {
+  if constexpr (searchStatsLevel >= 1) return to_string(searchStats.nodesExpanded);
+  return "n/a";
+}
+
+// Adds amount to a counter
+inline void countStat(uint64_t &counter, uint64_t amount = 1) {
+  if constexpr (searchStatsLevel >= 1) counter += amount;
+}
+
+// Raises a peak to value if it is larger
+inline void peakStat(uint64_t &peak, uint64_t value) {
+  if constexpr (searchStatsLevel >= 1) peak = max(peak, value);
+}
+
+// Charges the time since the previous charge to phase
+inline void chargeTime(double &phase) {
+  if constexpr (searchStatsLevel >= 2) {
+    chrono::steady_clock::time_point now = chrono::steady_clock::now();
+    phase += chrono::duration<double>(now - searchStats.lastCharge).count();
+    searchStats.lastCharge = now;
+  }
+}
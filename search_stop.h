@@ -0,0 +1,30 @@
+// Deadline and cancellation flag of a search, polled by the long-running
+// engines between expansions so that a solve can be bounded in time or
+// aborted from another thread.
+#pragma once
+
+#include <atomic>
+#include <chrono>
+
+using namespace std;
+
+const int stopCheckInterval = 256;                                        // Expansions between two polls
+
+// When a search has to give up: past the deadline or once cancelled is set,
+// whichever comes first. The default never stops.
+struct SearchStop {
+  chrono::steady_clock::time_point deadline = chrono::steady_clock::time_point::max();
+  const atomic<bool> *cancelled = nullptr;                                // Set by another thread to abort the search
+
+  bool requested() const {
+    if (cancelled != nullptr && cancelled->load(memory_order_relaxed)) return true;
+    return deadline != chrono::steady_clock::time_point::max() && chrono::steady_clock::now() >= deadline;
+  }
+};
+
+// A stop at a time limit from now
+SearchStop stopAfter(chrono::milliseconds timeLimit) {
+  SearchStop stop;
+  stop.deadline = chrono::steady_clock::now() + timeLimit;
+  return stop;
+}
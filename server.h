@@ -0,0 +1,563 @@
+// Resident solver service: reads JSON-lines solve requests from stdin or from
+// the clients of a Unix domain socket, queues them on a worker pool and
+// answers each one as soon as its solve finishes, in completion order.
+#pragma once
+
+#include <errno.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "batch.h"
+
+using namespace std;
+
+// -------------- JSON Lines --------------
+// Every request is a flat JSON object on one line. Field values are strings,
+// numbers or arrays of numbers, which is all the requests need.
+struct JsonField {
+  string raw;                                                             // Exact JSON text, echoed back in answers
+  string text;                                                            // Decoded string, or the numbers separated by spaces
+};
+
+// Parses one flat JSON object into its fields by name, false if malformed
+bool parseJsonLine(const string &line, map<string, JsonField> &fields) {
+  size_t at = 0;
+  auto skipSpace = [&] {
+    while (at < line.size() && isspace(static_cast<unsigned char>(line[at]))) ++at;
+  };
+  auto take = [&](char c) {
+    skipSpace();
+    if (at == line.size() || line[at] != c) return false;
+    ++at;
+    return true;
+  };
+  auto parseString = [&](string &text) {
+    if (!take('"')) return false;
+    text.clear();
+    while (at < line.size() && line[at] != '"') {
+      char c = line[at++];
+      if (c == '\\') {
+        if (at == line.size() || line[at] == 'u') return false;           // No request field needs \u escapes
+        char escaped = line[at++];
+        c = escaped == 'n' ? '\n' : escaped == 't' ? '\t' : escaped == 'r' ? '\r' : escaped; // \" \\ \/ stand for themselves
+      }
+      text += c;
+    }
+    return at++ < line.size();                                            // Past the closing quote
+  };
+  auto parseNumber = [&](string &text) {
+    skipSpace();
+    size_t start = at;
+    while (at < line.size() && (isdigit(static_cast<unsigned char>(line[at])) || strchr("+-.eE", line[at]) != nullptr)) ++at;
+    text = line.substr(start, at - start);
+    return at > start;
+  };
+
+  fields.clear();
+  if (!take('{')) return false;
+  if (!take('}')) {
+    do {
+      string name;
+      JsonField field;
+      if (!parseString(name) || !take(':')) return false;
+      skipSpace();
+      size_t start = at;
+      if (at < line.size() && line[at] == '"') {
+        if (!parseString(field.text)) return false;
+      } else if (take('[')) {
+        if (!take(']')) {
+          do {
+            string number;
+            if (!parseNumber(number)) return false;
+            field.text += (field.text.empty() ? "" : " ") + number;
+          } while (take(','));
+          if (!take(']')) return false;
+        }
+      } else if (!parseNumber(field.text)) {
+        return false;
+      }
+      field.raw = line.substr(start, at - start);
+      fields[name] = field;
+    } while (take(','));
+    if (!take('}')) return false;
+  }
+  skipSpace();
+  return at == line.size();
+}
+
+// Quotes a string for a JSON answer
+string jsonQuote(const string &text) {
+  string quoted = "\"";
+  for (char c : text) {
+    if (c == '"' || c == '\\') {
+      quoted += '\\';
+      quoted += c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      char escaped[8];
+      snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+      quoted += escaped;
+    } else {
+      quoted += c;
+    }
+  }
+  return quoted + '"';
+}
+
+// -------------- Server --------------
+const int serverAnytimeMs = 1000;                                         // Time an anytime solve gets without a deadline
+
+// Command-line options of server mode
+struct ServerOptions {
+  string socketPath = "-";                                                // Unix socket to listen on, "-" for stdin and stdout
+  int threads = 0;                                                        // 0 uses every hardware thread
+  string databasePath = "distances.db";                                   // Optional, db requests fail without it
+  int deadlineMs = 0;                                                     // Deadline of requests that set none, 0 for none
+  SearchBudget budget;                                                    // Memory of each bounded search
+  size_t cacheEntries = 0;                                                // Boards kept per board size, 0 for no cache
+};
+
+// Prints the command-line usage of server mode
+void printServerUsage() {
+  cout << "Usage: puzzle --serve [socket|-] [--threads N] [--db distances.db] [--pdb patterns.pdb]\n"
+          "              [--deadline-ms N] [--memory-budget BYTES[K|M|G]] [--node-budget N] [--cache N]\n"
+          "Answers one JSON request per line, from the clients of a Unix domain socket or from stdin:\n"
+          "  {\"id\": 1, \"board\": [1,2,3,8,0,4,7,6,5], \"algorithm\": \"ida\", \"heuristic\": 2, \"deadline_ms\": 500}\n"
+          "  {\"cancel\": 1}\n"
+          "The board has 9, 16 or 25 tiles, and an optional \"goal\" of the same size replaces the standard goal\n"
+          "(solved by IDA* with heuristic 1 or 2 and no cache when no rotation or reflection of it has the standard blank).\n"
+          "Answers come back as JSON lines as soon as each solve finishes.\n";
+}
+
+// Parses the server mode flags, false (after printing usage) on bad input
+bool parseServerOptions(int argc, char *argv[], ServerOptions &options) {
+  for (int i = 1; i < argc; ++i) {
+    string flag = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (flag == "--serve") {
+      if (hasValue && (argv[i + 1][0] != '-' || string(argv[i + 1]) == "-")) options.socketPath = argv[++i];
+    } else if (flag == "--threads" && hasValue) {
+      options.threads = atoi(argv[++i]);
+    } else if (flag == "--db" && hasValue) {
+      options.databasePath = argv[++i];
+    } else if (flag == "--pdb" && hasValue) {
+      patternDatabasePath = argv[++i];                                    // Used by heuristic 4 instead of building the tables
+    } else if (flag == "--deadline-ms" && hasValue) {
+      options.deadlineMs = atoi(argv[++i]);
+      if (options.deadlineMs < 1) {
+        cout << "The deadline must be at least 1 ms\n";
+        return false;
+      }
+    } else if (flag == "--memory-budget" && hasValue) {
+      if (!parseByteSize(argv[++i], options.budget.bytes)) {
+        cout << "The memory budget must be a number of bytes, optionally followed by K, M or G\n";
+        return false;
+      }
+    } else if (flag == "--node-budget" && hasValue) {
+      options.budget.nodes = strtoull(argv[++i], nullptr, 10);
+      if (options.budget.nodes == 0) {
+        cout << "The node budget must be at least 1\n";
+        return false;
+      }
+    } else if (flag == "--cache" && hasValue) {
+      options.cacheEntries = strtoull(argv[++i], nullptr, 10);
+    } else {
+      printServerUsage();
+      return false;
+    }
+  }
+  // A file for one board size is enough, the other sizes build their tables
+  if (!patternDatabasePath.empty() && patternDatabaseFileSize(patternDatabasePath) == 0) {
+    cout << "The pattern database " << patternDatabasePath << " is missing or corrupt, write one with build_pattern_db\n";
+    return false;
+  }
+  return true;
+}
+
+// One client, where the answers to its requests go. Shared with the
+// requests still in flight, so the socket closes after the last answer.
+class ServerConnection {
+ public:
+  const int id;
+
+  ServerConnection(int id, int fd, bool owned) : id(id), fd(fd), owned(owned) {}
+  ~ServerConnection() {
+    if (owned) close(fd);
+  }
+
+  void send(const string &answer) {                                       // One line, dropped if the client has gone
+    lock_guard<mutex> guard(writeLock);
+    string line = answer + '\n';
+    for (size_t sent = 0; sent < line.size();) {
+      ssize_t written = write(fd, line.data() + sent, line.size() - sent);
+      if (written < 0 && errno == EINTR) continue;
+      if (written <= 0) return;
+      sent += written;
+    }
+  }
+
+ private:
+  int fd;
+  bool owned;                                                             // Closed with the connection, unlike stdout
+  mutex writeLock;
+};
+
+// A solve request admitted to the queue
+struct ServerJob {
+  shared_ptr<ServerConnection> connection;
+  string key;                                                             // Connection and id, as registered
+  string id;                                                              // The request's id, as raw JSON
+  Algorithm algorithm;
+  int heuristicType;
+  int size;
+  int tiles[25];                                                          // Canonical board when a goal was given
+  bool canonical = false;                                                 // Solved in frame, for the request's goal
+  BoardFrame frame;
+  int goal[25];                                                           // The request's goal when no frame maps it
+  bool directGoal = false;                                                // Solved by idaStarToGoal, for goal
+  bool cacheable;                                                         // The algorithm gives optimal paths
+  atomic<bool> cancelled{false};
+  SearchStop stop;                                                        // Deadline, and cancelled above
+};
+
+/**
+ * @title Solver Service
+ * @brief Admits requests and runs them on a thread pool. Malformed requests
+ * and invalid or unsolvable boards are answered at once, by the reading
+ * thread, with the same parseBoard and isSolvable checks as batch mode, so
+ * they never take a worker. Admitted requests are registered by id until
+ * answered: a cancel request sets the job's flag, which the search polls
+ * along with the deadline. The deadline counts from admission, queueing
+ * included. Workers keep their search storage, the pattern databases and the
+ * optional solution caches warm between requests.
+ */
+class SolverService {
+ public:
+  SolverService(const ServerOptions &options, const DistanceDatabase *database)
+      : options(options), database(database), pool(options.threads > 0 ? options.threads : max(1u, thread::hardware_concurrency())) {
+    if (options.cacheEntries > 0) {
+      caches[0].reset(new SolutionCache(3, 3, options.cacheEntries));
+      caches[1].reset(new SolutionCache(4, 4, options.cacheEntries));
+    }
+  }
+
+  int newConnectionId() { return nextConnection++; }
+
+  // Handles one request line of a client
+  void handleLine(const shared_ptr<ServerConnection> &connection, const string &line) {
+    map<string, JsonField> fields;
+    if (!parseJsonLine(line, fields)) {
+      connection->send("{\"status\":\"error\",\"message\":\"malformed request\"}");
+      return;
+    }
+    auto target = fields.find("cancel");
+    if (target != fields.end()) {
+      cancel(*connection, target->second);
+      return;
+    }
+    auto id = fields.find("id");
+    if (id == fields.end()) {
+      connection->send("{\"status\":\"error\",\"message\":\"missing id\"}");
+      return;
+    }
+    admit(connection, id->second.raw, fields);
+  }
+
+ private:
+  ServerOptions options;
+  const DistanceDatabase *database;                                       // nullptr when no distance database was found
+  atomic<int> nextConnection{0};
+  unique_ptr<SolutionCache> caches[2];                                    // 3x3 and 4x4, if caching
+  mutex activeLock;
+  map<string, shared_ptr<ServerJob>> active;                              // Admitted and not answered yet
+  ThreadPool pool;                                                        // Last, so its jobs finish before the rest goes
+
+  static string answer(const string &id, const char *status, const string &details = "") {
+    return "{\"id\":" + id + ",\"status\":\"" + status + "\"" + details + "}";
+  }
+
+  // Field value, or fallback when the request leaves it out
+  static string field(const map<string, JsonField> &fields, const string &name, const string &fallback) {
+    auto found = fields.find(name);
+    return found == fields.end() ? fallback : found->second.text;
+  }
+
+  void cancel(ServerConnection &connection, const JsonField &target) {
+    bool found = false;
+    {
+      lock_guard<mutex> guard(activeLock);
+      auto job = active.find(to_string(connection.id) + ":" + target.raw);
+      if (job != active.end()) {
+        job->second->cancelled = true;
+        found = true;
+      }
+    }
+    connection.send("{\"cancel\":" + target.raw + ",\"status\":\"" + (found ? "cancelling" : "unknown") + "\"}");
+  }
+
+  void admit(const shared_ptr<ServerConnection> &connection, const string &id, const map<string, JsonField> &fields) {
+    auto refuse = [&](const string &message) { connection->send(answer(id, "error", ",\"message\":" + jsonQuote(message))); };
+    shared_ptr<ServerJob> job = make_shared<ServerJob>();
+    if (!parseAlgorithm(field(fields, "algorithm", "best"), job->algorithm)) return refuse("unknown algorithm");
+    job->heuristicType = atoi(field(fields, "heuristic", "2").c_str());
+    if (job->heuristicType < 1 || job->heuristicType > 4) return refuse("the heuristic must be 1, 2, 3 or 4");
+    int deadlineMs = atoi(field(fields, "deadline_ms", to_string(options.deadlineMs)).c_str());
+
+    string board = field(fields, "board", "");
+    istringstream count(board);
+    int cells = 0;
+    for (string tile; count >> tile;) ++cells;
+    job->size = cells == 9 ? 3 : cells == 16 ? 4 : 5;
+    if ((cells != 9 && cells != 16 && cells != 25) || !parseBoard(board, job->tiles, cells)) {
+      connection->send(answer(id, "invalid"));
+      return;
+    }
+
+    string goal = field(fields, "goal", "");
+    if (!goal.empty()) {
+      bool mapped = job->size == 3   ? canonicalizeJob<3, 3>(goal, *job)
+                    : job->size == 4 ? canonicalizeJob<4, 4>(goal, *job)
+                                     : canonicalizeJob<5, 5>(goal, *job);
+      if (!mapped) return refuse("the goal must be a board of the same size");
+    }
+
+    Algorithm algorithm = job->algorithm;
+    bool heuristicSearch = algorithm == ALG_BEST || algorithm == ALG_IDA || algorithm == ALG_BOUNDED || algorithm == ALG_ANYTIME;
+    if (algorithm == ALG_HDA || algorithm == ALG_PARALLEL_BFS) return refuse("hda and pbfs are not served, the pool is parallel already");
+    if (job->size == 5 && algorithm != ALG_IDA) return refuse("only ida solves 5x5 boards");
+    if (job->size == 4 && !heuristicSearch) return refuse("only best, bounded, anytime and ida solve 4x4 boards");
+    if (algorithm == ALG_DATABASE && database == nullptr) return refuse("no distance database, create it with build_distance_db");
+
+    bool solvable = job->size == 3   ? isSolvable(State(job->tiles))
+                    : job->size == 4 ? isBoardSolvable(makeBoard<4, 4>(job->tiles))
+                                     : isBoardSolvable(makeBoard<5, 5>(job->tiles));
+    if (job->directGoal) {                                                // Reachable only within the goal's parity class
+      solvable = solvable == (job->size == 3   ? isBoardSolvable(makeBoard<3, 3>(job->goal))
+                              : job->size == 4 ? isBoardSolvable(makeBoard<4, 4>(job->goal))
+                                               : isBoardSolvable(makeBoard<5, 5>(job->goal)));
+    }
+    if (!solvable) {
+      connection->send(answer(id, "unsolvable"));
+      return;
+    }
+
+    job->connection = connection;
+    job->id = id;
+    job->key = to_string(connection->id) + ":" + id;
+    job->cacheable = job->size < 5 && !job->directGoal && algorithm != ALG_DFS && algorithm != ALG_ANYTIME && !(heuristicSearch && job->heuristicType == 3);
+    job->stop.cancelled = &job->cancelled;
+    if (deadlineMs > 0) job->stop.deadline = chrono::steady_clock::now() + chrono::milliseconds(deadlineMs);
+    {
+      lock_guard<mutex> guard(activeLock);
+      if (!active.emplace(job->key, job).second) return refuse("a request with this id is in flight");
+    }
+    pool.submit([this, job] { run(*job); });
+  }
+
+  // Replaces the job's board by its canonical board for goal (symmetry.h), so
+  // that every goal shares the standard goal's tables and cache. A goal no
+  // frame maps is kept for idaStarToGoal instead. False if goal is not a board.
+  template <int W, int H>
+  static bool canonicalizeJob(const string &goal, ServerJob &job) {
+    int goalTiles[W * H];
+    if (!parseBoard(goal, goalTiles, W * H)) return false;
+    if (!goalHasFrame(makeBoard<W, H>(goalTiles))) {
+      copy(goalTiles, goalTiles + W * H, job.goal);
+      job.directGoal = true;
+      return true;
+    }
+    Board<W, H> canonical;
+    canonicalBoard(makeBoard<W, H>(job.tiles), makeBoard<W, H>(goalTiles), canonical, job.frame);
+    copy(canonical.tiles, canonical.tiles + W * H, job.tiles);
+    job.canonical = true;
+    return true;
+  }
+
+  // A*, bounded or anytime search of a board that fits a packed key
+  template <int W, int H>
+  bool searchPacked(const ServerJob &job, const Board<W, H> &board, vector<int> &blankPath, double &bound) {
+    if constexpr (W * H <= 16) {
+      if (job.algorithm == ALG_ANYTIME) {
+        SearchStop stop = job.stop;
+        if (stop.deadline == chrono::steady_clock::time_point::max()) stop.deadline = stopAfter(chrono::milliseconds(serverAnytimeMs)).deadline;
+        return anytimeAStar(board, job.heuristicType, stop, blankPath, bound);
+      }
+      SearchBudget budget = job.algorithm == ALG_BOUNDED ? options.budget : SearchBudget();
+      budget.stop = job.stop;
+      if (job.algorithm == ALG_BOUNDED) return boundedSearch(board, job.heuristicType, budget, blankPath);
+      int overBudgetBound;
+      return aStarWithinBudget(board, job.heuristicType, budget, blankPath, overBudgetBound);
+    } else {
+      return false;
+    }
+  }
+
+  template <int W, int H>
+  bool solve(const ServerJob &job, MoveSequence &moves, double &bound) {
+    Board<W, H> board = makeBoard<W, H>(job.tiles);
+    SolutionCache *cache = job.cacheable && W < 5 ? caches[W - 3].get() : nullptr;
+    vector<int> blankPath;
+    if (lookupCached(cache, board, blankPath)) {
+      moves = MoveSequence::fromBlankPath<W, H>(board.blank, blankPath);
+      return true;
+    }
+
+    bool found;
+    if (job.directGoal) {                                                 // Whatever the algorithm, no shared tables
+      found = idaStarToGoal(board, makeBoard<W, H>(job.goal), job.heuristicType, blankPath, &job.stop);
+      if (found && job.algorithm == ALG_ANYTIME) bound = 1;               // The path is optimal
+    } else if (job.algorithm == ALG_IDA) {
+      found = idaStar(board, job.heuristicType, blankPath, &job.stop);
+    } else if (job.algorithm == ALG_BEST || job.algorithm == ALG_BOUNDED || job.algorithm == ALG_ANYTIME) {
+      found = searchPacked(job, board, blankPath, bound);
+    } else {                                                              // dfs, bfs, bidir and db run to the end, in well under a second
+      if constexpr (W == 3 && H == 3) {
+        int tiles[9];
+        copy(job.tiles, job.tiles + 9, tiles);
+        found = solvePuzzle(job.algorithm, job.heuristicType, State(tiles), database, moves);
+        if (found) blankPath = moves.toBlankPath<3, 3>(board.blank);
+      } else {
+        found = false;
+      }
+      if (found) storeCached(cache, board, blankPath);
+      return found;
+    }
+    if (!found) return false;
+    moves = MoveSequence::fromBlankPath<W, H>(board.blank, blankPath);
+    storeCached(cache, board, blankPath);
+    return true;
+  }
+
+  void run(ServerJob &job) {
+    string result;
+    if (job.cancelled) {
+      result = answer(job.id, "cancelled");
+    } else if (job.stop.requested()) {
+      result = answer(job.id, "timeout");
+    } else {
+      auto start = chrono::steady_clock::now();
+      MoveSequence moves;
+      double bound = 0;
+      bool found = job.size == 3 ? solve<3, 3>(job, moves, bound) : job.size == 4 ? solve<4, 4>(job, moves, bound) : solve<5, 5>(job, moves, bound);
+      auto elapsed = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count();
+      ostringstream details;
+      details << ",\"micros\":" << elapsed;
+      if (found && job.canonical) {
+        moves = job.size == 3   ? movesFromFrame<3, 3>(moves, job.frame)
+                : job.size == 4 ? movesFromFrame<4, 4>(moves, job.frame)
+                                : movesFromFrame<5, 5>(moves, job.frame);
+      }
+      if (found) {
+        details << ",\"moves\":" << moves.size() << ",\"path\":\"" << moves.toString() << "\"";
+        if (job.algorithm == ALG_ANYTIME) details << ",\"bound\":" << bound;
+        result = answer(job.id, "solved", details.str());
+      } else {
+        result = answer(job.id, job.cancelled ? "cancelled" : job.stop.requested() ? "timeout" : "failed", details.str());
+      }
+    }
+    {
+      lock_guard<mutex> guard(activeLock);                                // Answered, so no longer cancellable
+      active.erase(job.key);
+    }
+    job.connection->send(result);
+  }
+};
+
+// Reads the request lines of one socket client until it disconnects
+void serveConnection(SolverService &service, shared_ptr<ServerConnection> connection, int fd) {
+  string pending;
+  char buffer[4096];
+  while (true) {
+    ssize_t received = read(fd, buffer, sizeof(buffer));
+    if (received < 0 && errno == EINTR) continue;
+    if (received <= 0) break;
+    pending.append(buffer, received);
+    size_t start = 0;
+    for (size_t end; (end = pending.find('\n', start)) != string::npos; start = end + 1) {
+      string line = pending.substr(start, end - start);
+      if (line.find_first_not_of(" \t\r") != string::npos) service.handleLine(connection, line);
+    }
+    pending.erase(0, start);
+  }
+}
+
+/**
+ * @title Server Mode
+ * @brief Serves solve requests until stdin ends (the queued requests are
+ * still answered) or, on a Unix domain socket, until the process is stopped.
+ * Each socket client gets a reading thread and its own answer stream, and its
+ * ids only need to be unique among its own requests in flight.
+ *
+ * @param options The parsed command-line options.
+ * @return The process exit code.
+ */
+int runServer(const ServerOptions &options) {
+  signal(SIGPIPE, SIG_IGN);                                               // Writes to a client that left fail instead
+  DistanceDatabase database;
+  bool haveDatabase = database.open(options.databasePath);
+  SolverService service(options, haveDatabase ? &database : nullptr);
+
+  if (options.socketPath == "-") {
+    auto connection = make_shared<ServerConnection>(service.newConnectionId(), STDOUT_FILENO, false);
+    string line;
+    while (getline(cin, line)) {
+      if (line.find_first_not_of(" \t\r") != string::npos) service.handleLine(connection, line);
+    }
+    return 0;
+  }
+
+  sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (options.socketPath.size() >= sizeof(address.sun_path)) {
+    cout << "The socket path " << options.socketPath << " is too long\n";
+    return 1;
+  }
+  strcpy(address.sun_path, options.socketPath.c_str());
+  int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+  unlink(options.socketPath.c_str());                                     // Left behind by an earlier server
+  if (listener < 0 || bind(listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0 || listen(listener, 64) < 0) {
+    cout << "Could not listen on " << options.socketPath << ": " << strerror(errno) << "\n";
+    return 1;
+  }
+  cout << "Listening on " << options.socketPath << endl;
+
+  mutex readerLock;
+  condition_variable readerDone;
+  int readers = 0;                                                        // Clients still connected
+  while (true) {
+    int client = accept(listener, nullptr, nullptr);
+    if (client < 0 && errno == EINTR) continue;
+    if (client < 0) break;
+    auto connection = make_shared<ServerConnection>(service.newConnectionId(), client, true);
+    {
+      lock_guard<mutex> guard(readerLock);
+      ++readers;
+    }
+    thread([&, connection, client] {
+      serveConnection(service, connection, client);
+      lock_guard<mutex> guard(readerLock);
+      if (--readers == 0) readerDone.notify_all();
+    }).detach();
+  }
+  cout << "Stopped accepting clients: " << strerror(errno) << "\n";
+  close(listener);
+  unique_lock<mutex> lock(readerLock);
+  readerDone.wait(lock, [&] { return readers == 0; });
+  return 1;
+}
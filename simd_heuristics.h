@@ -0,0 +1,350 @@
+// Batched heuristic evaluation over packed 8-puzzle boards. Each kernel
+// scores many boards per call without branches on the board contents: AVX2
+// handles two boards per instruction, SSSE3 one, and a table-driven scalar
+// loop is used when neither is enabled at compile time (e.g. -mavx2 or
+// -march=native). All paths return exactly what cTilesOutOfPlace, cManDist,
+// cSeqScore, cHeuristicH and isSolvable return for the same board.
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#if defined(__AVX2__) || defined(__SSSE3__)
+#include <immintrin.h>
+#endif
+
+#include "packed.h"
+#include "pattern_db.h"
+#include "puzzle.h"
+
+using namespace std;
+
+// -------------- Kernel Tables --------------
+// 16-byte shuffle tables derived from the 3x3 puzzle tables. Lanes 9-15 of an
+// unpacked board are always 0, and a shuffle index of 0x80 yields 0.
+struct SimdTables {
+  alignas(16) uint8_t goalRow[16];                                        // Goal row of each tile
+  alignas(16) uint8_t goalCol[16];                                        // Goal column of each tile
+  alignas(16) uint8_t cellRow[16];                                        // Row of each cell
+  alignas(16) uint8_t cellCol[16];                                        // Column of each cell
+  alignas(16) uint8_t goalTiles[16];                                      // Goal tile on each cell
+  alignas(16) uint8_t goalIndex[16];                                      // Goal cell of each tile
+  alignas(16) uint8_t ring[16];                                           // Perimeter cells clockwise
+  alignas(16) uint8_t ringNext[16];                                       // Clockwise neighbor of each perimeter cell
+  alignas(16) uint8_t successor[16];                                      // Goal successor of each tile on the ring
+  alignas(16) uint8_t cellMask[16];                                       // 0x0F on the 9 board cells, 0 elsewhere
+
+  constexpr SimdTables()
+      : goalRow(), goalCol(), cellRow(), cellCol(), goalTiles(), goalIndex(), ring(), ringNext(), successor(), cellMask() {
+    const PuzzleTables<3, 3> &tables = puzzleTables<3, 3>;
+    for (int i = 0; i < 16; ++i) {
+      ring[i] = ringNext[i] = 0x80;
+    }
+    for (int i = 0; i < 9; ++i) {
+      goalRow[i] = tables.goalIndex[i] / 3;
+      goalCol[i] = tables.goalIndex[i] % 3;
+      cellRow[i] = i / 3;
+      cellCol[i] = i % 3;
+      goalTiles[i] = tables.goal[i];
+      goalIndex[i] = tables.goalIndex[i];
+      successor[i] = tables.successor[i] < 0 ? 0xFF : tables.successor[i];
+      cellMask[i] = 0x0F;
+    }
+    for (int j = 0; j < 8; ++j) {
+      ring[j] = tables.ring[j];
+      ringNext[j] = tables.ring[(j + 1) % 8];
+    }
+  }
+};
+
+constexpr SimdTables simdTables{};
+
+// -------------- Scalar Kernels --------------
+int scalarManhattan(PackedState board) {
+  int total = 0;
+  for (int i = 0; i < 9; ++i) total += puzzleTables<3, 3>.manhattan[board.tileAt(i)][i];
+  return total;
+}
+
+int scalarMisplaced(PackedState board) {
+  int total = 0;
+  for (int i = 0; i < 9; ++i) total += puzzleTables<3, 3>.misplaced[board.tileAt(i)][i];
+  return total;
+}
+
+int scalarSequenceScore(PackedState board) {
+  const PuzzleTables<3, 3> &tables = puzzleTables<3, 3>;
+  int score = board.tileAt(tables.blankGoal) != 0;
+  for (int j = 0; j < 8; ++j) {
+    int tile = board.tileAt(tables.ring[j]);
+    int next = board.tileAt(tables.ring[(j + 1) % 8]);
+    score += 2 * (tile != 0 && next != tables.successor[tile]);
+  }
+  return score;
+}
+
+bool scalarSolvable(PackedState board) {
+  const PuzzleTables<3, 3> &tables = puzzleTables<3, 3>;
+  int inversions = 0;
+  for (int i = 0; i < 9; ++i) {
+    int a = board.tileAt(i);
+    for (int j = i + 1; j < 9; ++j) {
+      int b = board.tileAt(j);
+      inversions += a != 0 && b != 0 && tables.goalIndex[a] > tables.goalIndex[b];
+    }
+  }
+  return inversions % 2 == 0;
+}
+
+#if defined(__SSSE3__)
+// -------------- SSSE3 Kernels (one board) --------------
+#define SIMD_LOAD(table) _mm_load_si128(reinterpret_cast<const __m128i *>(simdTables.table))
+
+// Spreads the 4-bit cells of a packed board over bytes 0-8, zeroing the rest
+__m128i unpackCells(PackedState board) {
+  __m128i packed = _mm_cvtsi64_si128(int64_t(board.bits));
+  __m128i low = _mm_set1_epi8(0x0F);
+  __m128i even = _mm_and_si128(packed, low);
+  __m128i odd = _mm_and_si128(_mm_srli_epi16(packed, 4), low);
+  return _mm_and_si128(_mm_unpacklo_epi8(even, odd), SIMD_LOAD(cellMask));
+}
+
+int horizontalSum(__m128i sums) {                                         // Adds the two 64-bit halves of a _mm_sad_epu8 result
+  return _mm_cvtsi128_si32(_mm_add_epi64(sums, _mm_unpackhi_epi64(sums, sums)));
+}
+
+int simdManhattan(__m128i cells) {
+  __m128i blank = _mm_cmpeq_epi8(cells, _mm_setzero_si128());
+  __m128i cellRow = SIMD_LOAD(cellRow), cellCol = SIMD_LOAD(cellCol);
+  __m128i row = _mm_shuffle_epi8(SIMD_LOAD(goalRow), cells);
+  __m128i col = _mm_shuffle_epi8(SIMD_LOAD(goalCol), cells);
+  row = _mm_or_si128(_mm_andnot_si128(blank, row), _mm_and_si128(blank, cellRow)); // The blank contributes no distance
+  col = _mm_or_si128(_mm_andnot_si128(blank, col), _mm_and_si128(blank, cellCol));
+  return horizontalSum(_mm_add_epi64(_mm_sad_epu8(row, cellRow), _mm_sad_epu8(col, cellCol)));
+}
+
+int simdMisplaced(__m128i cells) {
+  __m128i home = _mm_or_si128(_mm_cmpeq_epi8(cells, SIMD_LOAD(goalTiles)), _mm_cmpeq_epi8(cells, _mm_setzero_si128()));
+  return 16 - __builtin_popcount(_mm_movemask_epi8(home));
+}
+
+int simdSequenceScore(__m128i cells, PackedState board) {
+  __m128i tile = _mm_shuffle_epi8(cells, SIMD_LOAD(ring));
+  __m128i next = _mm_shuffle_epi8(cells, SIMD_LOAD(ringNext));
+  __m128i expected = _mm_shuffle_epi8(SIMD_LOAD(successor), tile);
+  __m128i fine = _mm_or_si128(_mm_cmpeq_epi8(next, expected), _mm_cmpeq_epi8(tile, _mm_setzero_si128()));
+  return 2 * (16 - __builtin_popcount(_mm_movemask_epi8(fine))) + (board.tileAt(puzzleTables<3, 3>.blankGoal) != 0);
+}
+
+template <int shift>
+__m128i inversionsAt(__m128i position, __m128i tiles) {                   // -1 per pair (i, i + shift) out of goal order
+  __m128i later = _mm_srli_si128(position, shift);
+  __m128i both = _mm_and_si128(tiles, _mm_srli_si128(tiles, shift));
+  return _mm_and_si128(_mm_cmpgt_epi8(position, later), both);
+}
+
+bool simdSolvable(__m128i cells) {
+  __m128i position = _mm_shuffle_epi8(SIMD_LOAD(goalIndex), cells);
+  __m128i tiles = _mm_xor_si128(_mm_cmpeq_epi8(cells, _mm_setzero_si128()), _mm_set1_epi8(-1));
+  __m128i count = _mm_setzero_si128();
+  count = _mm_sub_epi8(count, inversionsAt<1>(position, tiles));
+  count = _mm_sub_epi8(count, inversionsAt<2>(position, tiles));
+  count = _mm_sub_epi8(count, inversionsAt<3>(position, tiles));
+  count = _mm_sub_epi8(count, inversionsAt<4>(position, tiles));
+  count = _mm_sub_epi8(count, inversionsAt<5>(position, tiles));
+  count = _mm_sub_epi8(count, inversionsAt<6>(position, tiles));
+  count = _mm_sub_epi8(count, inversionsAt<7>(position, tiles));
+  count = _mm_sub_epi8(count, inversionsAt<8>(position, tiles));
+  return horizontalSum(_mm_sad_epu8(count, _mm_setzero_si128())) % 2 == 0;
+}
+#endif
+
+#if defined(__AVX2__)
+// -------------- AVX2 Kernels (two boards, one per 128-bit lane) --------------
+#define SIMD_LOAD2(table) _mm256_broadcastsi128_si256(SIMD_LOAD(table))
+
+__m256i unpackCellPair(PackedState first, PackedState second) {
+  __m256i packed = _mm256_set_epi64x(0, int64_t(second.bits), 0, int64_t(first.bits));
+  __m256i low = _mm256_set1_epi8(0x0F);
+  __m256i even = _mm256_and_si256(packed, low);
+  __m256i odd = _mm256_and_si256(_mm256_srli_epi16(packed, 4), low);
+  return _mm256_and_si256(_mm256_unpacklo_epi8(even, odd), SIMD_LOAD2(cellMask));
+}
+
+void storePairSums(__m256i sums, int *out) {                              // Adds the 64-bit halves of each lane's _mm256_sad_epu8 result
+  alignas(32) int64_t lanes[4];
+  _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), sums);
+  out[0] = int(lanes[0] + lanes[1]);
+  out[1] = int(lanes[2] + lanes[3]);
+}
+
+void simdManhattanPair(__m256i cells, int *out) {
+  __m256i blank = _mm256_cmpeq_epi8(cells, _mm256_setzero_si256());
+  __m256i cellRow = SIMD_LOAD2(cellRow), cellCol = SIMD_LOAD2(cellCol);
+  __m256i row = _mm256_shuffle_epi8(SIMD_LOAD2(goalRow), cells);
+  __m256i col = _mm256_shuffle_epi8(SIMD_LOAD2(goalCol), cells);
+  row = _mm256_blendv_epi8(row, cellRow, blank);                          // The blank contributes no distance
+  col = _mm256_blendv_epi8(col, cellCol, blank);
+  storePairSums(_mm256_add_epi64(_mm256_sad_epu8(row, cellRow), _mm256_sad_epu8(col, cellCol)), out);
+}
+
+void simdMisplacedPair(__m256i cells, int *out) {
+  __m256i home = _mm256_or_si256(_mm256_cmpeq_epi8(cells, SIMD_LOAD2(goalTiles)), _mm256_cmpeq_epi8(cells, _mm256_setzero_si256()));
+  uint32_t mask = _mm256_movemask_epi8(home);
+  out[0] = 16 - __builtin_popcount(mask & 0xFFFF);
+  out[1] = 16 - __builtin_popcount(mask >> 16);
+}
+
+void simdSequenceScorePair(__m256i cells, PackedState first, PackedState second, int *out) {
+  __m256i tile = _mm256_shuffle_epi8(cells, SIMD_LOAD2(ring));
+  __m256i next = _mm256_shuffle_epi8(cells, SIMD_LOAD2(ringNext));
+  __m256i expected = _mm256_shuffle_epi8(SIMD_LOAD2(successor), tile);
+  __m256i fine = _mm256_or_si256(_mm256_cmpeq_epi8(next, expected), _mm256_cmpeq_epi8(tile, _mm256_setzero_si256()));
+  uint32_t mask = _mm256_movemask_epi8(fine);
+  out[0] = 2 * (16 - __builtin_popcount(mask & 0xFFFF)) + (first.tileAt(puzzleTables<3, 3>.blankGoal) != 0);
+  out[1] = 2 * (16 - __builtin_popcount(mask >> 16)) + (second.tileAt(puzzleTables<3, 3>.blankGoal) != 0);
+}
+#endif
+
+// -------------- Batch API --------------
+/**
+ * @title Batch Manhattan Distance
+ * @brief Writes cManDist of boards[i] to out[i] for every board.
+ */
+void batchManhattan(const PackedState *boards, size_t count, int *out) {
+  size_t i = 0;
+#if defined(__AVX2__)
+  for (; i + 2 <= count; i += 2) simdManhattanPair(unpackCellPair(boards[i], boards[i + 1]), out + i);
+#endif
+#if defined(__SSSE3__)
+  for (; i < count; ++i) out[i] = simdManhattan(unpackCells(boards[i]));
+#else
+  for (; i < count; ++i) out[i] = scalarManhattan(boards[i]);
+#endif
+}
+
+// Writes cTilesOutOfPlace of every board to out
+void batchMisplaced(const PackedState *boards, size_t count, int *out) {
+  size_t i = 0;
+#if defined(__AVX2__)
+  for (; i + 2 <= count; i += 2) simdMisplacedPair(unpackCellPair(boards[i], boards[i + 1]), out + i);
+#endif
+#if defined(__SSSE3__)
+  for (; i < count; ++i) out[i] = simdMisplaced(unpackCells(boards[i]));
+#else
+  for (; i < count; ++i) out[i] = scalarMisplaced(boards[i]);
+#endif
+}
+
+// Writes cSeqScore of every board to out
+void batchSequenceScore(const PackedState *boards, size_t count, int *out) {
+  size_t i = 0;
+#if defined(__AVX2__)
+  for (; i + 2 <= count; i += 2) {
+    simdSequenceScorePair(unpackCellPair(boards[i], boards[i + 1]), boards[i], boards[i + 1], out + i);
+  }
+#endif
+#if defined(__SSSE3__)
+  for (; i < count; ++i) out[i] = simdSequenceScore(unpackCells(boards[i]), boards[i]);
+#else
+  for (; i < count; ++i) out[i] = scalarSequenceScore(boards[i]);
+#endif
+}
+
+// Writes isSolvable of every board to out
+void batchSolvable(const PackedState *boards, size_t count, bool *out) {
+  for (size_t i = 0; i < count; ++i) {
+#if defined(__SSSE3__)
+    out[i] = simdSolvable(unpackCells(boards[i]));
+#else
+    out[i] = scalarSolvable(boards[i]);
+#endif
+  }
+}
+
+// -------------- Heuristic Functors --------------
+// One type per heuristic, scoring a batch of boards, so that a search
+// templated on it inlines the kernel instead of switching on the heuristic
+// number for every batch. informed is false for the zero heuristic of the
+// uninformed searches, which never call it.
+struct ZeroHeuristic {
+  static constexpr bool informed = false;
+  void operator()(const PackedState *, size_t count, int *out) const { fill(out, out + count, 0); }
+};
+
+struct MisplacedHeuristic {                                               // Heuristic 1
+  static constexpr bool informed = true;
+  void operator()(const PackedState *boards, size_t count, int *out) const { batchMisplaced(boards, count, out); }
+};
+
+struct ManhattanHeuristic {                                               // Heuristic 2
+  static constexpr bool informed = true;
+  void operator()(const PackedState *boards, size_t count, int *out) const { batchManhattan(boards, count, out); }
+};
+
+struct SequenceHeuristic {                                                // Heuristic 3, H = totdist + 3 * seq
+  static constexpr bool informed = true;
+  void operator()(const PackedState *boards, size_t count, int *out) const {
+    int sequence[16];
+    for (size_t start = 0; start < count; start += 16) {                  // In chunks of 16
+      size_t chunk = min(count - start, size_t(16));
+      batchManhattan(boards + start, chunk, out + start);
+      batchSequenceScore(boards + start, chunk, sequence);
+      for (size_t i = 0; i < chunk; ++i) out[start + i] += 3 * sequence[i];
+    }
+  }
+};
+
+struct PatternHeuristic {                                                 // Heuristic 4, no vector kernel
+  static constexpr bool informed = true;
+  const PatternDatabase<3, 3> &database = defaultPatternDatabase<3, 3>();
+  void operator()(const PackedState *boards, size_t count, int *out) const {
+    for (size_t i = 0; i < count; ++i) {
+      int tiles[9];
+      unpackBoard(boards[i], tiles);
+      out[i] = database.evaluate(makeBoard<3, 3>(tiles));
+    }
+  }
+};
+
+// Calls visit with the number of a heuristic as in the menu made a
+// compile-time constant, 3 for any number but 1, 2 and 4: the only place that
+// switches on the number. Searches pass through it once, by withHeuristic for
+// packed 8-puzzle boards or withBoardHeuristic for W x H boards.
+template <typename Visit>
+auto withHeuristicNumber(int heuristicType, Visit &&visit) {
+  switch (heuristicType) {
+    case 1:
+      return visit(integral_constant<int, 1>());
+    case 2:
+      return visit(integral_constant<int, 2>());
+    case 4:
+      return visit(integral_constant<int, 4>());
+    default:
+      return visit(integral_constant<int, 3>());
+  }
+}
+
+// Calls visit with the packed 8-puzzle functor of a heuristic numbered as in the menu
+template <typename Visit>
+auto withHeuristic(int heuristicType, Visit &&visit) {
+  return withHeuristicNumber(heuristicType, [&](auto number) {
+    if constexpr (decltype(number)::value == 1) return visit(MisplacedHeuristic());
+    else if constexpr (decltype(number)::value == 2) return visit(ManhattanHeuristic());
+    else if constexpr (decltype(number)::value == 4) return visit(PatternHeuristic());
+    else return visit(SequenceHeuristic());
+  });
+}
+
+/**
+ * @title Batch Heuristic
+ * @brief Writes the heuristic of every board to out, numbered as in the menu
+ * (1 misplaced tiles, 2 Manhattan distance, 3 the heuristic H, 4 the pattern
+ * database, which has no vector kernel and is looked up board by board).
+ * Searches pick the functor once through withHeuristic instead.
+ */
+void batchHeuristic(const PackedState *boards, size_t count, int heuristicType, int *out) {
+  withHeuristic(heuristicType, [&](const auto &heuristic) { heuristic(boards, count, out); });
+}
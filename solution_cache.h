@@ -0,0 +1,178 @@
+// Cache of optimal solutions in front of the solvers. Every board on a cached
+// optimal path is answered by the rest of that path, so one solve serves many
+// later queries, and the cache can be saved to a file and loaded back.
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "packed.h"
+#include "puzzle.h"
+
+using namespace std;
+
+// -------------- Cache File Layout --------------
+// A SolutionCacheHeader, then one record per stored path, least recently used
+// first: the key of its first board (uint64_t), its number of moves (uint16_t)
+// and the blank index after each move, one byte each.
+const char cacheMagic[4] = {'8', 'P', 'S', 'C'};                          // File signature
+const uint32_t cacheVersion = 1;                                          // Bumped whenever the layout changes
+
+struct SolutionCacheHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t width, height;                                                 // Boards of other sizes are rejected on load
+  uint64_t pathCount;
+};
+
+/**
+ * @title Solution Cache
+ * @brief LRU cache from boards packed 4 bits per cell (packBoardKey) to
+ * optimal blank paths. Inserting a path adds an entry for every board along
+ * it, each pointing into the one shared copy of the path at its own offset:
+ * the suffix of an optimal path is optimal for the board it starts from. The
+ * least recently used entries are evicted beyond capacity, and a path is
+ * freed with its last entry. Lookups and inserts take a lock, the solving
+ * in between does not.
+ */
+class SolutionCache {
+ public:
+  SolutionCache(int width, int height, size_t capacity) : width(width), height(height), capacity(max<size_t>(1, capacity)) {}
+
+  size_t size() {
+    lock_guard<mutex> guard(lock);
+    return index.size();
+  }
+
+  // Fills blankPath with the cached moves from the board, false on a miss
+  bool lookup(uint64_t key, vector<int> &blankPath) {
+    lock_guard<mutex> guard(lock);
+    auto found = index.find(key);
+    if (found == index.end()) return false;
+    recency.splice(recency.begin(), recency, found->second);              // Now the most recently used
+    const Entry &entry = *found->second;
+    blankPath.assign(entry.path->begin() + entry.offset, entry.path->end());
+    return true;
+  }
+
+  // Adds the optimal path from the board (key, blank index) and its suffixes
+  void insert(uint64_t key, int blank, const vector<int> &blankPath) {
+    if (blankPath.empty()) return;                                        // The goal needs no entry
+    auto path = make_shared<vector<uint8_t>>(blankPath.begin(), blankPath.end());
+    lock_guard<mutex> guard(lock);
+    for (size_t offset = 0; offset < path->size(); ++offset) {
+      auto found = index.find(key);
+      if (found == index.end()) {
+        recency.push_front({key, path, uint32_t(offset)});
+        index[key] = recency.begin();
+      } else {
+        recency.splice(recency.begin(), recency, found->second);          // Already known, and just as short
+      }
+      int newBlank = (*path)[offset];
+      key = applyKeyMove(key, blank, newBlank);
+      blank = newBlank;
+    }
+    while (index.size() > capacity) {
+      index.erase(recency.back().key);
+      recency.pop_back();
+    }
+  }
+
+  // Writes every cached path once, from its earliest still cached board,
+  // returns false on I/O errors
+  bool save(const string &filePath) {
+    lock_guard<mutex> guard(lock);
+    unordered_map<const vector<uint8_t> *, const Entry *> earliest;       // Cached entry with the lowest offset per path
+    vector<const Entry *> order;                                          // First entry seen of each path, oldest first
+    for (auto entry = recency.rbegin(); entry != recency.rend(); ++entry) {
+      const Entry *&known = earliest[entry->path.get()];
+      if (known == nullptr) order.push_back(&*entry);
+      if (known == nullptr || entry->offset < known->offset) known = &*entry;
+    }
+
+    ofstream out(filePath, ios::binary | ios::trunc);
+    if (!out) return false;
+    SolutionCacheHeader header;
+    memcpy(header.magic, cacheMagic, sizeof(cacheMagic));
+    header.version = cacheVersion;
+    header.width = width;
+    header.height = height;
+    header.pathCount = order.size();
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    for (const Entry *first : order) {
+      const Entry *entry = earliest[first->path.get()];
+      uint16_t length = entry->path->size() - entry->offset;
+      out.write(reinterpret_cast<const char *>(&entry->key), sizeof(entry->key));
+      out.write(reinterpret_cast<const char *>(&length), sizeof(length));
+      out.write(reinterpret_cast<const char *>(entry->path->data() + entry->offset), length);
+    }
+    return bool(out);
+  }
+
+  // Adds the paths of a file written by save, false if it cannot be read,
+  // holds boards of another size or a path that is not a run of legal moves
+  // ending on the goal
+  bool load(const string &filePath) {
+    ifstream in(filePath, ios::binary);
+    SolutionCacheHeader header;
+    if (!in.read(reinterpret_cast<char *>(&header), sizeof(header))) return false;
+    if (memcmp(header.magic, cacheMagic, sizeof(cacheMagic)) != 0 || header.version != cacheVersion ||
+        header.width != uint32_t(width) || header.height != uint32_t(height)) {
+      return false;
+    }
+    for (uint64_t i = 0; i < header.pathCount; ++i) {
+      uint64_t key;
+      uint16_t length;
+      if (!in.read(reinterpret_cast<char *>(&key), sizeof(key)) || !in.read(reinterpret_cast<char *>(&length), sizeof(length))) {
+        return false;
+      }
+      vector<uint8_t> bytes(length);
+      if (!in.read(reinterpret_cast<char *>(bytes.data()), length)) return false;
+      int cells = width * height, blank = 0;
+      while (blank < cells && ((key >> (4 * blank)) & packedCellMask) != 0) ++blank; // The first board's blank
+      bool valid = blank < cells && (width == 3 && height == 3   ? reachesGoal<3, 3>(key, blank, bytes)
+                                     : width == 4 && height == 4 ? reachesGoal<4, 4>(key, blank, bytes)
+                                                                 : false);
+      if (!valid) return false;
+      insert(key, blank, vector<int>(bytes.begin(), bytes.end()));
+    }
+    return true;
+  }
+
+ private:
+  struct Entry {
+    uint64_t key;
+    shared_ptr<const vector<uint8_t>> path;                               // Blank index after each move
+    uint32_t offset;                                                      // Moves of the path before this board
+  };
+
+  int width, height;
+  size_t capacity;                                                        // Most boards kept
+  list<Entry> recency;                                                    // Most recently used first
+  unordered_map<uint64_t, list<Entry>::iterator> index;
+  mutex lock;
+
+  // Replays a loaded path, true if every step moves the blank to a neighbor
+  // cell and the last board is the goal
+  template <int W, int H>
+  static bool reachesGoal(uint64_t key, int blank, const vector<uint8_t> &blankPath) {
+    for (uint8_t next : blankPath) {
+      const int8_t *neighbors = puzzleTables<W, H>.neighbors[blank];
+      if (next >= W * H) return false;                                    // 0xFF would match the -1 of a missing neighbor
+      if (find(neighbors, neighbors + 4, int8_t(next)) == neighbors + 4) return false;
+      key = applyKeyMove(key, blank, next);
+      blank = next;
+    }
+    uint64_t goal = 0;
+    for (int i = 0; i < W * H; ++i) goal |= uint64_t(puzzleTables<W, H>.goal[i]) << (4 * i);
+    return key == goal;
+  }
+};
@@ -0,0 +1,147 @@
+// Symmetries of the grid and tile relabelings that map a board with any goal
+// layout onto the standard goal, so that its searches, distance tables and
+// caches serve every goal, and symmetric boards share one cache entry.
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "move_sequence.h"
+#include "puzzle.h"
+
+using namespace std;
+
+// -------------- Grid Symmetries --------------
+/**
+ * @title Grid Symmetries
+ * @brief The 8 rotations and reflections of a square grid, or the 4 of them
+ * that keep a rectangular grid in shape, built at compile time. Symmetry 0 is
+ * the identity. A symmetry moves every cell, and turns a move of the blank in
+ * direction d into a move in direction direction[s][d] on the moved board.
+ */
+template <int W, int H>
+struct GridSymmetries {
+  static constexpr int cells = W * H;
+  static constexpr int count = W == H ? 8 : 4;
+
+  int8_t cell[8][cells];                                                  // Image of every cell
+  int8_t direction[8][4];                                                 // Image of every blank direction
+  int8_t inverseDirection[8][4];                                          // Direction whose image is d
+
+  constexpr GridSymmetries() : cell(), direction(), inverseDirection() {
+    const int rowStep[4] = {-1, 1, 0, 0}, colStep[4] = {0, 0, -1, 1};     // Up, Down, Left, Right
+    for (int s = 0; s < count; ++s) {
+      for (int i = 0; i < cells; ++i) {
+        int row = i / W, col = i % W;
+        cell[s][i] = image(s, row, col, H - 1, W - 1);
+      }
+      for (int d = 0; d < 4; ++d) {                                       // The image of a step, as a step from the origin
+        int moved = image(s, rowStep[d], colStep[d], 0, 0) - image(s, 0, 0, 0, 0);
+        for (int e = 0; e < 4; ++e) {
+          if (rowStep[e] * W + colStep[e] == moved) direction[s][d] = e;
+        }
+        inverseDirection[s][direction[s][d]] = d;
+      }
+    }
+  }
+
+  // Cell of (row, col) under symmetry s, lastRow and lastCol being H - 1 and
+  // W - 1 (or 0 to map a step rather than a cell)
+  static constexpr int image(int s, int row, int col, int lastRow, int lastCol) {
+    switch (s) {
+      case 1: return (lastRow - row) * W + (lastCol - col);                // Half turn
+      case 2: return row * W + (lastCol - col);                            // Mirror left to right
+      case 3: return (lastRow - row) * W + col;                            // Mirror top to bottom
+      case 4: return col * W + row;                                        // Transpose, square grids only
+      case 5: return (lastCol - col) * W + (lastRow - row);                // Anti-transpose
+      case 6: return col * W + (lastRow - row);                            // Quarter turn clockwise
+      case 7: return (lastCol - col) * W + row;                            // Quarter turn counter-clockwise
+      default: return row * W + col;
+    }
+  }
+};
+
+template <int W, int H>
+constexpr GridSymmetries<W, H> gridSymmetries{};
+
+// -------------- Board Frames --------------
+// How a problem was mapped onto the standard goal: a symmetry of the grid,
+// then a relabeling of the tiles. The blank keeps label 0.
+struct BoardFrame {
+  int symmetry = 0;
+  uint8_t relabel[25];                                                    // New label of every tile
+};
+
+// Applies a frame to a board
+template <int W, int H>
+Board<W, H> toFrame(const Board<W, H> &board, const BoardFrame &frame) {
+  Board<W, H> moved;
+  for (int i = 0; i < W * H; ++i) moved.tiles[gridSymmetries<W, H>.cell[frame.symmetry][i]] = frame.relabel[board.tiles[i]];
+  moved.blank = gridSymmetries<W, H>.cell[frame.symmetry][board.blank];
+  return moved;
+}
+
+// Frame that takes goal onto the standard goal with symmetry s, false if s
+// does not put the goal's blank on the standard goal's blank cell
+template <int W, int H>
+bool frameForGoal(const Board<W, H> &goal, int s, BoardFrame &frame) {
+  const int8_t *cell = gridSymmetries<W, H>.cell[s];
+  if (cell[goal.blank] != puzzleTables<W, H>.blankGoal) return false;
+  frame.symmetry = s;
+  for (int i = 0; i < W * H; ++i) frame.relabel[goal.tiles[i]] = puzzleTables<W, H>.goal[cell[i]];
+  return true;
+}
+
+// Whether some symmetry brings the goal's blank onto the standard blank cell,
+// which canonicalBoard needs
+template <int W, int H>
+bool goalHasFrame(const Board<W, H> &goal) {
+  BoardFrame frame;
+  for (int s = 0; s < GridSymmetries<W, H>::count; ++s) {
+    if (frameForGoal(goal, s, frame)) return true;
+  }
+  return false;
+}
+
+/**
+ * @title Canonical Board
+ * @brief Maps the problem of taking board to goal onto the standard goal.
+ * Among the symmetries that put the goal's blank on the standard blank cell,
+ * it picks the one whose relabeled board has the smallest tiles in row-major
+ * order, so every board of a symmetry class (up to 8 on square grids) has the
+ * same representative. Goals whose blank no symmetry can bring onto the
+ * standard blank cell cannot be mapped: the 8-puzzle serves goals with a
+ * centered blank, the 15-puzzle those with the blank on one of the four
+ * inner cells. Batch and server modes solve the other goals directly with
+ * idaStarToGoal (ida_search.h).
+ *
+ * @param board The board to solve.
+ * @param goal The goal of the problem.
+ * @param canonical Set to the representative, to be solved for the standard goal.
+ * @param frame Set to the frame that maps board to canonical.
+ * @return false if the goal cannot be mapped onto the standard goal.
+ */
+template <int W, int H>
+bool canonicalBoard(const Board<W, H> &board, const Board<W, H> &goal, Board<W, H> &canonical, BoardFrame &frame) {
+  bool found = false;
+  BoardFrame candidate;
+  for (int s = 0; s < GridSymmetries<W, H>::count; ++s) {
+    if (!frameForGoal(goal, s, candidate)) continue;
+    Board<W, H> moved = toFrame(board, candidate);
+    if (!found || lexicographical_compare(moved.tiles, moved.tiles + W * H, canonical.tiles, canonical.tiles + W * H)) {
+      canonical = moved;
+      frame = candidate;
+      found = true;
+    }
+  }
+  return found;
+}
+
+// Maps moves found in a frame back to moves of the original board
+template <int W, int H>
+MoveSequence movesFromFrame(const MoveSequence &moves, const BoardFrame &frame) {
+  MoveSequence original;
+  for (size_t i = 0; i < moves.size(); ++i) original.push(gridSymmetries<W, H>.inverseDirection[frame.symmetry][moves[i]]);
+  return original;
+}
@@ -0,0 +1,231 @@
+// Seeded streams of solvable boards with a chosen mix of optimal depths,
+// drawn straight from an index of every board by distance, for load tests
+// and engine comparisons that need reproducible hard cases.
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "distance_db.h"
+#include "external_bfs.h"
+
+using namespace std;
+
+// -------------- Depth Index --------------
+/**
+ * @title Depth Index
+ * @brief Every board of a puzzle grouped by its optimal distance to the
+ * goal, as packed keys (packBoardKey), so that the i-th board of a depth is
+ * one array read. The 8-puzzle index is built in memory from the retrograde
+ * search of the distance database (1.4 MB, boards in rank order within a
+ * depth). Larger puzzles are read from a distance file of external_bfs,
+ * memory-mapped, whose layers are already sorted by key; it covers the
+ * depths the file was built to, and only a file searched from the goal is
+ * accepted, since the depths of any other start are not distances to it.
+ */
+class DepthIndex {
+ public:
+  DepthIndex() {}
+  DepthIndex(const DepthIndex &) = delete;
+  DepthIndex &operator=(const DepthIndex &) = delete;
+  ~DepthIndex() { close(); }
+
+  int width = 0, height = 0;
+
+  int maxDepth() const { return int(layers.size()) - 1; }
+  uint64_t count(int depth) const { return depth >= 0 && depth <= maxDepth() ? layers[depth].count : 0; }
+  uint64_t key(int depth, uint64_t i) const { return layers[depth].keys[i]; }
+
+  void buildEightPuzzle() {                                               // Every solvable 8-puzzle board
+    close();
+    vector<uint8_t> entries;
+    buildDistanceTable(entries);
+    vector<uint64_t> start(dbDistanceMask + 2, 0);                        // Counting sort by depth, ranks stay in order
+    for (uint8_t entry : entries) {
+      if (entry != dbUnreachable) ++start[(entry & dbDistanceMask) + 1];
+    }
+    int deepest = 0;
+    for (int d = 1; d < int(start.size()); ++d) {
+      if (start[d] > 0) deepest = d - 1;
+      start[d] += start[d - 1];
+    }
+    owned.resize(start.back());
+    vector<uint64_t> next(start.begin(), start.end() - 1);
+    for (uint32_t rank = 0; rank < stateCount; ++rank) {
+      if (entries[rank] == dbUnreachable) continue;
+      PackedState state = unrankPacked(rank);
+      owned[next[entries[rank] & dbDistanceMask]++] = state.bits & ~(packedCellMask << packedBlankShift);
+    }
+    for (int d = 0; d <= deepest; ++d) layers.push_back({owned.data() + start[d], start[d + 1] - start[d]});
+    width = height = 3;
+  }
+
+  bool open(const string &path) {                                         // Maps a distance file, false if missing or invalid
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || size_t(info.st_size) < sizeof(ExternalDistanceHeader)) {
+      ::close(fd);
+      return false;
+    }
+    void *data = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);                                                          // The mapping stays valid after closing
+    if (data == MAP_FAILED) return false;
+    mapping = data;
+    mappingSize = info.st_size;
+
+    const char *bytes = static_cast<const char *>(data);
+    const ExternalDistanceHeader *header = reinterpret_cast<const ExternalDistanceHeader *>(bytes);
+    bool valid = memcmp(header->magic, externalMagic, sizeof(externalMagic)) == 0 && header->version == externalVersion &&
+                 header->width * header->height <= 16;
+    size_t at = sizeof(ExternalDistanceHeader);
+    while (valid && at < mappingSize) {                                   // Layers follow in order of distance
+      const ExternalLayerHeader *layer = reinterpret_cast<const ExternalLayerHeader *>(bytes + at);
+      at += sizeof(ExternalLayerHeader);
+      valid = at <= mappingSize && layer->distance == layers.size() &&
+              layer->count <= (mappingSize - at) / sizeof(uint64_t);
+      if (!valid) break;
+      layers.push_back({reinterpret_cast<const uint64_t *>(bytes + at), layer->count});
+      at += layer->count * sizeof(uint64_t);
+    }
+    if (valid && !layers.empty()) {                                       // Distances must be from the goal, not a --start board
+      uint64_t goal = goalKey(header->width, header->height);
+      valid = goal != 0 && layers[0].count == 1 && layers[0].keys[0] == goal;
+    }
+    if (!valid || layers.empty()) {
+      close();
+      return false;
+    }
+    width = header->width;
+    height = header->height;
+    return true;
+  }
+
+  void close() {
+    if (mapping != nullptr) munmap(mapping, mappingSize);
+    mapping = nullptr;
+    mappingSize = 0;
+    owned.clear();
+    layers.clear();
+    width = height = 0;
+  }
+
+ private:
+  struct Layer {
+    const uint64_t *keys;
+    uint64_t count;
+  };
+
+  static uint64_t goalKey(uint32_t width, uint32_t height) {              // 0 for the sizes external_bfs does not build
+    if (width == 3 && height == 3) return packBoardKey(goalBoard<3, 3>());
+    if (width == 4 && height == 4) return packBoardKey(goalBoard<4, 4>());
+    return 0;
+  }
+
+  vector<Layer> layers;
+  vector<uint64_t> owned;                                                 // Keys of a built index
+  void *mapping = nullptr;
+  size_t mappingSize = 0;
+};
+
+// -------------- Depth Mix --------------
+/**
+ * @title Depth Mix Parser
+ * @brief Turns a depth specification into one integer weight per depth of
+ * the index. The specification is "natural", which weighs every depth by its
+ * number of boards (a uniform draw over all boards), or a comma-separated
+ * list of depths "20" and ranges "18-24", each with an optional weight
+ * ":3" (default 1) shared by every depth of the item.
+ *
+ * @return false (after printing why) if the specification does not parse or
+ * asks for a depth the index has no boards at.
+ */
+bool parseDepthMix(const string &spec, const DepthIndex &index, vector<uint64_t> &weights) {
+  weights.assign(index.maxDepth() + 1, 0);
+  if (spec == "natural") {
+    for (int d = 0; d <= index.maxDepth(); ++d) weights[d] = index.count(d);
+    return true;
+  }
+  stringstream stream(spec);
+  for (string item; getline(stream, item, ',');) {
+    char *end;
+    long first = strtol(item.c_str(), &end, 10), last = first;
+    bool valid = end != item.c_str() && first >= 0;
+    if (valid && *end == '-') last = strtol(end + 1, &end, 10);
+    unsigned long long weight = 1;
+    if (valid && *end == ':') weight = strtoull(end + 1, &end, 10);
+    if (!valid || *end != '\0' || last < first || weight == 0) {
+      cout << "Bad depth, range or weight " << item << endl;
+      return false;
+    }
+    for (int d = first; d <= last; ++d) {
+      if (index.count(d) == 0) {
+        cout << "No board is at depth " << d << ", the index goes up to " << index.maxDepth() << endl;
+        return false;
+      }
+      weights[d] += weight;
+    }
+  }
+  if (count(weights.begin(), weights.end(), 0) == long(weights.size())) {
+    cout << "The depth mix is empty" << endl;
+    return false;
+  }
+  return true;
+}
+
+// -------------- Generator --------------
+/**
+ * @title Workload Generator
+ * @brief Draws boards by first drawing a depth with the mix's weights, then
+ * a board of that depth uniformly, two mt19937_64 outputs per board and no
+ * search. mt19937_64's output is fixed by the standard and the draws use it
+ * directly (no std distributions, whose output is not), so a seed, a mix and
+ * an index always give the same stream.
+ */
+class WorkloadGenerator {
+ public:
+  WorkloadGenerator(const DepthIndex &index, const vector<uint64_t> &weights, uint64_t seed) : index(index), random(seed) {
+    uint64_t total = 0;
+    for (uint64_t weight : weights) cumulative.push_back(total += weight);
+  }
+
+  // Packed key (packBoardKey) of the next board, depth set to its optimal depth
+  uint64_t next(int &depth) {
+    uint64_t pick = random() % cumulative.back();
+    depth = int(upper_bound(cumulative.begin(), cumulative.end(), pick) - cumulative.begin());
+    return index.key(depth, random() % index.count(depth));
+  }
+
+ private:
+  const DepthIndex &index;
+  mt19937_64 random;
+  vector<uint64_t> cumulative;                                            // Running total of the weights by depth
+};
+
+// -------------- Workload File Layout --------------
+// A WorkloadFileHeader, then one 9-byte record per board: its packed key
+// (uint64_t, 4 bits per cell, in host byte order) and its optimal depth
+// (uint8_t).
+const char workloadMagic[4] = {'8', 'P', 'W', 'L'};                       // File signature
+const uint32_t workloadVersion = 1;                                       // Bumped whenever the layout changes
+
+struct WorkloadFileHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t width, height;
+  uint64_t count;                                                         // Number of records
+};